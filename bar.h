@@ -37,6 +37,15 @@
 #include <string>
 #include <vector>
 #include <functional>
+#include <algorithm>
+#include <list>
+#include <unordered_map>
+
+#include "helper.h"
+#include "xrender_backend.h"
+#include "shm_backend.h"
+#include "stats.h"
+#include "log.h"
 
 #include <iostream>
 #include <string>
@@ -54,11 +63,32 @@
 #define min(a,b) ((a) < (b) ? (a) : (b))
 #define indexof(c,s) (strchr((s),(c))-(s))
 
+// Métricas de un glifo Xft ya medido
+struct GlyphMetrics {
+    int16_t advance;     // xOff: avance del cursor
+    int16_t bearingX;    // x: desplazamiento del origen al borde izquierdo
+    int16_t bearingY;    // y: desplazamiento del origen al borde superior
+    uint16_t width;      // extents del bitmap
+    uint16_t height;
+    uint16_t drawWidth;  // ancho que ocupa en la barra: max(advance, width)
+};
+
+// Cache de métricas de una fuente. ASCII va en una tabla plana, el resto en
+// un hash que crece a medida que aparecen codepoints nuevos.
+struct GlyphCache {
+    GlyphMetrics ascii[128];
+    bool asciiValid[128] = {};
+    std::unordered_map<uint32_t, GlyphMetrics> others;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+};
+
 typedef struct font_t {
     xcb_font_t ptr;
     xcb_charinfo_t *width_lut;
 
     XftFont *xft_ft;
+    GlyphCache *glyphs;
 
     int ascent;
 
@@ -71,6 +101,9 @@ typedef struct monitor_t {
     int x, y, width;
     xcb_window_t window;
     xcb_pixmap_t pixmap;
+    // Monitor cuyo pixmap se copia a esta ventana. Los monitores del mismo
+    // ancho que el primario usan el suyo; uno más ancho es su propia fuente.
+    struct monitor_t *source;
     struct monitor_t *prev, *next;
 } monitor_t;
 
@@ -84,6 +117,13 @@ enum { ALIGN_L = 0,
     ALIGN_R
 };
 
+// Backend de texto, se elige al arrancar
+enum {
+    RENDER_XFT = 0,     // XftDraw sobre Xlib (por defecto)
+    RENDER_XRENDER,     // glyphsets propios sobre xcb-render
+    RENDER_SHM,         // rasterizado en el cliente, presentado con MIT-SHM
+};
+
 enum {
     GC_DRAW = 0,
     GC_CLEAR,
@@ -92,8 +132,10 @@ enum {
 };
 
 #define MAX_FONT_COUNT 5
-//char width lookuptable
-#define MAX_WIDTHS (1 << 16)
+// Marca en el cache de fuentes: ninguna fuente tiene el glifo
+#define FONT_SLOT_NONE 0xFF
+// Un item de PolyText16 admite hasta 254 caracteres
+#define MAX_RUN_LEN 254
 
 // Funciones helper UTF-8 para evitar duplicación
 struct UTF8Result {
@@ -101,16 +143,65 @@ struct UTF8Result {
     int bytesConsumed;
 };
 
+// Estado atado a la conexión con X. Lo comparten todas las barras del
+// proceso: una sola conexión, un solo juego de fuentes y un solo cache de
+// glifos. Cada barra conserva sus ventanas, pixmaps, GCs y cache de render.
+struct BarDisplay {
+    Display *dpy = nullptr;
+    xcb_connection_t *c = nullptr;
+
+    xcb_screen_t *scr = nullptr;
+    int scrNbr = 0;
+
+    xcb_visualid_t visual = 0;
+    Visual *visualPtr = nullptr;
+    xcb_colormap_t colormap = 0;
+    int visualDepth = 0; // depth of chosen visual (bits)
+
+    font_t *fontList[MAX_FONT_COUNT];
+    int fontCount = 0;
+    int offsetsY[MAX_FONT_COUNT];
+    int offsetYCount = 0;
+
+    // Cache codepoint -> fuente (ver Bar::fontSlotFor)
+    uint8_t bmpFontSlots[0x10000] = {};
+    std::unordered_map<uint32_t, uint8_t> astralFontSlots;
+
+    // Backend que quedó después de inicializar la primera barra
+    int renderBackend = RENDER_XFT;
+    XRenderGlyphBackend xrender;
+    ShmGlyphCache shmGlyphs;
+
+    int users = 0; // barras que la usan; la última cierra la conexión
+
+    // Secuencia del último marcador de stats: los requests de X que se
+    // mandaron entre dos marcadores son los que cuentan las stats
+    unsigned int statsSequence = 0;
+};
 
 class Bar{
 
     struct CachedSeparator {
         uint32_t ucs[2];       // los dos caracteres Unicode
-        font_t* fonts[2];      // sus fuentes seleccionadas
-        int widths[2];          // ancho de cada carácter
+        uint8_t fontSlots[2];   // sus fuentes seleccionadas (índice en fontList)
+        uint8_t widths[2];      // ancho de cada carácter
         int totalWidth;         // ancho total del separador
     };
     CachedSeparator separator;
+
+    // "…" que cierra un elemento recortado
+    struct CachedEllipsis {
+        uint32_t ucs;
+        uint8_t fontSlot;
+        uint8_t width;
+    };
+    CachedEllipsis ellipsis;
+    void initEllipsis() {
+        ellipsis.ucs = 0x2026;
+        ellipsis.fontSlot = resolveGlyph(ellipsis.ucs);
+        ellipsis.width = getUtf8CharWidth(ellipsis.ucs, fontList[ellipsis.fontSlot]);
+    }
+
     void initSeparator() {
         const char* sep_string = " ▏";
         const char* p = sep_string;
@@ -120,13 +211,12 @@ class Bar{
 
         while (*p != '\0' && i < 2) {
             UTF8Result result = decodeUtf8Char(p);
-            font_t* f = selectDrawableFont(result.ucs);
-            if (!f) result.ucs = '?';
+            int slot = resolveGlyph(result.ucs);
 
-            int w = getUtf8CharWidth(result.ucs, f);
+            int w = getUtf8CharWidth(result.ucs, fontList[slot]);
 
             separator.ucs[i] = result.ucs;
-            separator.fonts[i] = f;
+            separator.fontSlots[i] = slot;
             separator.widths[i] = w;
             separator.totalWidth += w;
 
@@ -136,35 +226,55 @@ class Bar{
     }
 
 public:
-    wchar_t xftChar[MAX_WIDTHS];
-    char    xftWidth[MAX_WIDTHS];
     XftColor selFg;
-    XftDraw *xftDraw;
-    Display *dpy;
-    xcb_connection_t *c;
+    XftDraw *xftDraw = nullptr;
 
-    xcb_screen_t *scr;
-    int scrNbr = 0;
+    // Lo compartido vive en display; los alias mantienen los nombres de
+    // siempre en el resto de la clase
+    BarDisplay *display;
+    Display *&dpy;
+    xcb_connection_t *&c;
 
-    xcb_gcontext_t gc[GC_MAX];
-    xcb_visualid_t visual;
-    Visual *visualPtr;
-    xcb_colormap_t colormap;
-    int visualDepth = 0; // depth of chosen visual (bits)
+    xcb_screen_t *&scr;
+    int &scrNbr;
 
+    xcb_visualid_t &visual;
+    Visual *&visualPtr;
+    xcb_colormap_t &colormap;
+    int &visualDepth;
+
+    font_t **fontList;
+    int &fontCount;
+    int *offsetsY;
+    int &offsetYCount;
+
+    uint8_t *bmpFontSlots;
+    std::unordered_map<uint32_t, uint8_t> &astralFontSlots;
+
+    XRenderGlyphBackend &xrender;
+
+    int renderBackend = RENDER_XFT;
+    ShmSurface shm;
+
+    xcb_gcontext_t gc[GC_MAX];
 
     monitor_t *monhead, *montail;
-    font_t *fontList[MAX_FONT_COUNT];
-    int fontCount = 0;
+    // Monitor en el que se dibuja: el más angosto, así el layout entra en
+    // todos. El resto copia de su pixmap (ver assignMonitorSources).
+    monitor_t *primary = nullptr;
+    // Fin de la sección izquierda e inicio de la derecha en el último layout,
+    // y lo que quedó armado en los monitores más anchos
+    int leftEnd = 0, rightStart = 0;
+    int composedLeftEnd = -1, composedRightStart = -1;
     int fontIndex = -1;
-    int offsetsY[MAX_FONT_COUNT];
-    int offsetYCount = 0;
     int offsetYIndex = 0;
 
     uint32_t attrs = 0;
     bool dock = false; // hace que la barra siempre sea visible en la pantalla
     bool topbar = true;
     int bw = -1, bh = -1, bx = 0, by = 0;
+    int requestedBw = -1; // bw antes de ajustarlo a los outputs
+    std::string wmName, wmInstance;
     int bu = 1; // Underline height
     Color
     foregroundColor,
@@ -183,6 +293,86 @@ public:
 
     /* Flag to prevent infinite EXPOSE loop */
     bool processingExpose = false;
+    bool exposePending = false;
+
+    // Damage tracking: tramos horizontales [x0, x1) del pixmap modificados
+    // en el frame actual. La barra es una sola fila, basta con intervalos en x.
+    struct DamageSpan {
+        int x0, x1;
+    };
+    std::vector<DamageSpan> damage;
+    std::vector<BarElement*> dirtyElements;
+
+    // Texto decodificado de todos los elementos de la barra, y el buffer
+    // donde se decodifica antes de saber el largo
+    TextArena textArena;
+    uint32_t parseUcs[CONTENT_MAX_LEN];
+    uint8_t parseWidths[CONTENT_MAX_LEN];
+    uint8_t parseFonts[CONTENT_MAX_LEN];
+
+    // Índice de clicks: tramos [x0, x1) del layout con handlers, ordenados
+    // por x. Se arma en layoutElements y un click se resuelve con una
+    // búsqueda binaria. Guarda módulo e índice y no el puntero: un módulo
+    // bloqueante puede republicar sus elementos antes del próximo layout.
+    struct HitSpan {
+        int x0, x1;
+        Module *module;
+        size_t index;
+    };
+    std::vector<HitSpan> hitIndex;
+    std::vector<int> separatorX;
+    std::vector<int> drawnSeparatorX;
+    bool fullRedraw = true;
+
+    // Lo que quedó dibujado en el frame anterior, por elemento. Un elemento
+    // que desaparece ya no está en los módulos para limpiar su área: se
+    // limpia desde acá aunque en el mismo frame aparezca otro en su lugar.
+    struct DrawnExtent {
+        BarElement *element;
+        int x, width;
+    };
+    std::vector<DrawnExtent> drawnExtents;
+    std::vector<BarElement*> liveElements;
+
+    // Cache de elementos ya rasterizados. Cada entrada es un pixmap de
+    // width x bh con el elemento dibujado; la clave combina renderHash(),
+    // ancho y largo del contenido. La entrada guarda además lo que se
+    // hasheó, así una colisión del hash se detecta y se vuelve a rasterizar.
+    // Se expulsa por LRU al superar el límite.
+    struct CachedRender {
+        xcb_pixmap_t pixmap;
+        uint32_t bytes;
+        std::list<uint64_t>::iterator lru;
+        std::string content;
+        uint32_t style[BarElement::STYLE_WORDS];
+        int visibleLen;
+
+        bool matches(const BarElement* element) const {
+            uint32_t other[BarElement::STYLE_WORDS];
+            element->styleWords(other);
+            return visibleLen == element->visibleLen &&
+                   memcmp(style, other, sizeof(style)) == 0 &&
+                   content.size() == (size_t)element->renderedLen() &&
+                   memcmp(content.data(), element->content, content.size()) == 0;
+        }
+    };
+    std::unordered_map<uint64_t, CachedRender> renderCache;
+    std::list<uint64_t> renderLru;
+    size_t renderCacheBytes = 0;
+    size_t renderCacheLimit = 4 << 20; // 4 MiB de pixmaps en el servidor
+    uint64_t renderCacheHits = 0;
+    uint64_t renderCacheMisses = 0;
+    uint64_t renderCacheEvictions = 0;
+
+    // Claves vistas una vez, en una tabla fija indexada por la clave. Un
+    // elemento se dibuja directo la primera vez y recién se cachea si la
+    // misma clave vuelve: el texto que no se repite (segundos, tasas) no
+    // paga pixmap ni entrada. Una colisión solo pierde una oportunidad.
+    static const size_t RENDER_SEEN_SLOTS = 256;
+    uint64_t renderSeen[RENDER_SEEN_SLOTS] = {};
+
+    // Tiempos por frame y caches, para el endpoint de stats.h
+    BarStats *stats;
 
     const std::vector<Module*> leftModules;
     const std::vector<Module*> rightModules;
@@ -190,32 +380,44 @@ public:
 
 public:
 
-    inline UTF8Result decodeUtf8Char(const char* input) {
+    // Decodifica un carácter de a lo sumo avail bytes. Una secuencia que no
+    // entra o a la que le falta un byte de continuación (p.ej. un '\0') se
+    // toma como un byte inválido: nunca se lee más allá del terminador.
+    inline UTF8Result decodeUtf8Char(const char* input, int avail = 4) {
         const uint8_t *utf = (const uint8_t *)input;
-        UTF8Result result = {0, 1};
+        UTF8Result result = {utf[0], 1};
 
+        int need;
+        uint32_t ucs;
         if (utf[0] < 0x80) {
             // ASCII (1 byte)
-            result.ucs = utf[0];
-            result.bytesConsumed = 1;
+            return result;
         } else if ((utf[0] & 0xe0) == 0xc0) {
             // UTF-8 de 2 bytes
-            result.ucs = (utf[0] & 0x1f) << 6 | (utf[1] & 0x3f);
-            result.bytesConsumed = 2;
+            need = 2;
+            ucs = utf[0] & 0x1f;
         } else if ((utf[0] & 0xf0) == 0xe0) {
             // UTF-8 de 3 bytes
-            result.ucs = (utf[0] & 0xf) << 12 | (utf[1] & 0x3f) << 6 | (utf[2] & 0x3f);
-            result.bytesConsumed = 3;
+            need = 3;
+            ucs = utf[0] & 0xf;
         } else if ((utf[0] & 0xf8) == 0xf0) {
             // UTF-8 de 4 bytes
-            result.ucs = (utf[0] & 0x07) << 18 | (utf[1] & 0x3f) << 12 | (utf[2] & 0x3f) << 6 | (utf[3] & 0x3f);
-            result.bytesConsumed = 4;
+            need = 4;
+            ucs = utf[0] & 0x07;
         } else {
             // Byte inválido
-            result.ucs = utf[0];
-            result.bytesConsumed = 1;
+            return result;
         }
 
+        if (need > avail)
+            return result;
+        for (int k = 1; k < need; k++) {
+            if ((utf[k] & 0xc0) != 0x80)
+                return result;
+            ucs = ucs << 6 | (utf[k] & 0x3f);
+        }
+        result.ucs = ucs;
+        result.bytesConsumed = need;
         return result;
     }
 
@@ -237,18 +439,42 @@ public:
         const bool topBar,
         const std::vector<std::string> &fonts,
         const std::vector<Module*> &leftModules,
-        const std::vector<Module*> &rightModules
+        const std::vector<Module*> &rightModules,
+        const int backend = RENDER_XFT,
+        Bar *shareWith = nullptr
     ) :
+        display(shareWith ? shareWith->display : new BarDisplay()),
+        dpy(display->dpy),
+        c(display->c),
+        scr(display->scr),
+        scrNbr(display->scrNbr),
+        visual(display->visual),
+        visualPtr(display->visualPtr),
+        colormap(display->colormap),
+        visualDepth(display->visualDepth),
+        fontList(display->fontList),
+        fontCount(display->fontCount),
+        offsetsY(display->offsetsY),
+        offsetYCount(display->offsetYCount),
+        bmpFontSlots(display->bmpFontSlots),
+        astralFontSlots(display->astralFontSlots),
+        xrender(display->xrender),
+        renderBackend(backend),
         topbar(topBar),
         leftModules(leftModules),
         rightModules(rightModules)
     {
         modules.insert(modules.end(), leftModules.begin(), leftModules.end());
         modules.insert(modules.end(), rightModules.begin(), rightModules.end());
-
-        //connect();
-        for (const auto& font : fonts) {
-            fontLoad(font.c_str());
+        stats = Stats::instance().bar(name);
+
+        // Las fuentes son de la conexión: una barra que comparte display usa
+        // las que cargó la primera
+        bool firstBar = display->users++ == 0;
+        if (firstBar) {
+            for (const auto& font : fonts) {
+                fontLoad(font.c_str());
+            }
         }
         //setClickHandler(cb);
         //Color::parse_color(hex, NULL, (Color)0x00000000U)
@@ -257,16 +483,45 @@ public:
         defaultForegroundColor = foregroundColor = Color::parse_color(_foregroundColor, NULL, (Color)0x11111111U);
         defaultUnderlineColor = underlineColor = foregroundColor;
 
-        // Connect to X and initialize
-        xconn();
-        fprintf(stderr, "[lemonbar] lemonbar_init_lib: xconn complete\n");
+        // Connect to X and initialize. fontLoad() ya abre la conexión; abrir
+        // otra acá dejaría las fuentes en un Display distinto al de la barra.
+        if (!dpy || !c)
+            xconn();
+        LOG_DEBUG("[lemonbar] lemonbar_init_lib: xconn complete");
+
+        if (firstBar) {
+            if (renderBackend == RENDER_XRENDER && !xrender.init(c, visual)) {
+                LOG_WARN("[lemonbar] xrender backend unavailable, falling back to Xft");
+                renderBackend = RENDER_XFT;
+            }
+        } else {
+            // Los glyphsets de xrender ya están (o no) en el display
+            renderBackend = display->renderBackend;
+        }
+
+        if (renderBackend == RENDER_SHM) {
+            // El rasterizado en el cliente solo sabe dibujar fuentes Xft
+            bool allXft = true;
+            for (int i = 0; i < fontCount; i++)
+                allXft = allXft && fontList[i]->xft_ft;
+            if (!allXft || !shm.init(c, &display->shmGlyphs)) {
+                LOG_WARN("[lemonbar] shm backend unavailable, falling back to Xft");
+                renderBackend = RENDER_XFT;
+            }
+        }
 
         // init() expects fonts to be loaded already; caller should call fontLoad()
         init((char *)name, (char *)name);
-        fprintf(stderr, "[lemonbar] lemonbar_init_lib: init complete\n");
+        LOG_DEBUG("[lemonbar] lemonbar_init_lib: init complete");
+
+        // El display hereda el backend que la primera barra pudo usar de
+        // verdad, después de los chequeos de shm (init y resize)
+        if (firstBar)
+            display->renderBackend = renderBackend;
 
         //setBackground(_backgroundColor);
         initSeparator();
+        initEllipsis();
     }
 
     void setClickHandler(std::function<void(const char *cmd)> cb) {
@@ -277,15 +532,28 @@ public:
         // Only update if colors are dirty
         if (!colorsDirty) return;
 
+        // En modo shm los colores se leen al pintar, no hay nada que mandar
+        if (renderBackend == RENDER_SHM) {
+            colorsDirty = false;
+            return;
+        }
+
         xcb_change_gc(c, gc[GC_DRAW], XCB_GC_FOREGROUND, (const uint32_t []){ foregroundColor.v });
         xcb_change_gc(c, gc[GC_CLEAR], XCB_GC_FOREGROUND, (const uint32_t []){ backgroundColor.v });
         xcb_change_gc(c, gc[GC_ATTR], XCB_GC_FOREGROUND, (const uint32_t []){ underlineColor.v });
+
+        // El backend xrender toma el color directamente de foregroundColor
+        if (renderBackend == RENDER_XRENDER) {
+            colorsDirty = false;
+            return;
+        }
+
         XftColorFree(dpy, visualPtr, colormap , &selFg);
         char color[] = "#ffffff";
         uint32_t nfgc = foregroundColor.v & 0x00ffffff;
         snprintf(color, sizeof(color), "#%06X", nfgc);
         if (!XftColorAllocName (dpy, visualPtr, colormap, color, &selFg)) {
-            fprintf(stderr, "Couldn't allocate xft font color '%s'\n", color);
+            LOG_ERROR("Couldn't allocate xft font color '%s'", color);
         }
 
         // Mark colors as clean
@@ -384,110 +652,172 @@ public:
     }
 
 
-    int xftCharWidthSlot(uint32_t ch) {
-        int slot = ch % MAX_WIDTHS;
-        while (xftChar[slot] != 0 && xftChar[slot] != ch)
-        {
-            slot = (slot + 1) % MAX_WIDTHS;
+    int fontSlotOf(font_t* curFont) {
+        for (int i = 0; i < fontCount; i++) {
+            if (fontList[i] == curFont)
+                return i;
         }
-        return slot;
+        return 0;
     }
 
-    int xftCharWidth(uint32_t ch, font_t* curFont) {
-        int slot = xftCharWidthSlot(ch);
-        if (!xftChar[slot]) {
-            XGlyphInfo gi;
+    GlyphMetrics measureGlyph(font_t* curFont, uint32_t ch) {
+        XGlyphInfo gi;
+        if (renderBackend == RENDER_XRENDER) {
+            // Medir es rasterizar y subir el glifo al glyphset una sola vez
+            xrender.loadGlyph(fontSlotOf(curFont), curFont->xft_ft, ch, &gi);
+        } else if (renderBackend == RENDER_SHM) {
+            display->shmGlyphs.loadGlyph(fontSlotOf(curFont), curFont->xft_ft, ch, &gi);
+        } else {
             FT_UInt glyph = XftCharIndex (dpy, curFont->xft_ft, (FcChar32) ch);
-            XftFontLoadGlyphs (dpy, curFont->xft_ft, FcFalse, &glyph, 1);
+            // XftGlyphExtents carga el glifo si hace falta y lo deja cargado,
+            // que es justo lo que se necesita para dibujarlo después
             XftGlyphExtents (dpy, curFont->xft_ft, &glyph, 1, &gi);
-            XftFontUnloadGlyphs (dpy, curFont->xft_ft, &glyph, 1);
-            xftChar[slot] = ch;
-            if (gi.xOff >= gi.width) {
-                xftWidth[slot] = gi.xOff;
-            } else {
-                xftWidth[slot] = gi.width;
-            }
-            return xftWidth[slot];
-        } else if (xftChar[slot] == ch)
-            return xftWidth[slot];
-        else
-            return 0;
+        }
+
+        GlyphMetrics m;
+        m.advance = gi.xOff;
+        m.bearingX = gi.x;
+        m.bearingY = gi.y;
+        m.width = gi.width;
+        m.height = gi.height;
+        m.drawWidth = (gi.xOff >= (int)gi.width) ? gi.xOff : gi.width;
+        return m;
     }
 
-    int shift(monitor_t* mon, int x, int align, int chWidth) {
-        switch (align) {
-            case ALIGN_C:
-                xcb_copy_area(c, mon->pixmap, mon->pixmap, gc[GC_DRAW],
-                              mon->width / 2 - x / 2, 0,
-                              mon->width / 2 - (x + chWidth) / 2, 0,
-                              x, bh);
-                x = mon->width / 2 - (x + chWidth) / 2 + x;
-                break;
-            case ALIGN_R:
-                xcb_copy_area(c, mon->pixmap, mon->pixmap, gc[GC_DRAW],
-                              mon->width - x, 0,
-                              mon->width - x - chWidth, 0,
-                              x, bh);
-                x = mon->width - chWidth;
-                break;
+    const GlyphMetrics& glyphMetrics(font_t* curFont, uint32_t ch) {
+        GlyphCache* cache = curFont->glyphs;
+
+        if (ch < 128) {
+            if (!cache->asciiValid[ch]) {
+                cache->misses++;
+                cache->ascii[ch] = measureGlyph(curFont, ch);
+                cache->asciiValid[ch] = true;
+            } else {
+                cache->hits++;
+            }
+            return cache->ascii[ch];
         }
 
-        /* Draw the background first */
-        fillRect(mon->pixmap, gc[GC_CLEAR], x, 0, chWidth, bh);
-        return x;
+        auto it = cache->others.find(ch);
+        if (it != cache->others.end()) {
+            cache->hits++;
+            return it->second;
+        }
+        cache->misses++;
+        return cache->others.emplace(ch, measureGlyph(curFont, ch)).first->second;
     }
 
-    void drawLines(monitor_t* mon, int x, int w) {
-        /* We can render both at the same time */
-        if (attrs & ATTR_OVERL)
-            fillRect(mon->pixmap, gc[GC_ATTR], x, 0, w, bu);
-        if (attrs & ATTR_UNDERL)
-            fillRect(mon->pixmap, gc[GC_ATTR], x, bh - bu, w, bu);
+    int xftCharWidth(uint32_t ch, font_t* curFont) {
+        return glyphMetrics(curFont, ch).drawWidth;
     }
 
-    void drawShift(monitor_t* mon, int x, int align, int w) {
-        x = shift(mon, x, align, w);
-        drawLines(mon, x, w);
+    // Mide de antemano ASCII imprimible y los rangos de iconos de helper.h en
+    // la fuente que efectivamente los va a dibujar, para que el primer frame
+    // no tenga que ir a FreeType.
+    void prewarmGlyphCaches(void) {
+        for (uint32_t ch = 0x20; ch < 0x7f; ch++) {
+            int slot = fontSlotFor(ch);
+            if (slot >= 0 && fontList[slot]->xft_ft)
+                glyphMetrics(fontList[slot], ch);
+        }
+        for (const Helper::CodepointRange& range : Helper::ICON_RANGES) {
+            for (uint32_t ch = range.first; ch <= range.last; ch++) {
+                int slot = fontSlotFor(ch);
+                if (slot >= 0 && fontList[slot]->xft_ft)
+                    glyphMetrics(fontList[slot], ch);
+            }
+        }
+        for (int i = 0; i < fontCount; i++) {
+            if (fontList[i]->glyphs)
+                fontList[i]->glyphs->hits = fontList[i]->glyphs->misses = 0;
+        }
     }
 
-    int drawChar(monitor_t* mon, font_t* curFont, int x, int align, uint32_t ch) {
-        int chWidth;
-
-        if (curFont->xft_ft) {
-            chWidth = xftCharWidth(ch, curFont);
+    // Rellena con el color de uno de los gc (GC_DRAW/GC_CLEAR/GC_ATTR) sobre
+    // la superficie del monitor; en modo shm el rectángulo se pinta en memoria.
+    void paintRect(monitor_t* mon, int gcIndex, int x, int y, int width, int height) {
+        if (renderBackend == RENDER_SHM) {
+            const Color& color = gcIndex == GC_CLEAR ? backgroundColor :
+                                 gcIndex == GC_ATTR ? underlineColor : foregroundColor;
+            shm.fillRect(x, y, width, height, color.v);
         } else {
-            chWidth = (curFont->width_lut) ?
-                curFont->width_lut[ch - curFont->charMin].character_width:
-                curFont->width;
+            fillRect(mon->pixmap, gc[gcIndex], x, y, width, height);
         }
+    }
 
-        x = shift(mon, x, align, chWidth);
+    void drawLines(monitor_t* mon, int x, int w) {
+        /* We can render both at the same time */
+        if (attrs & ATTR_OVERL)
+            paintRect(mon, GC_ATTR, x, 0, w, bu);
+        if (attrs & ATTR_UNDERL)
+            paintRect(mon, GC_ATTR, x, bh - bu, w, bu);
+    }
 
-        int y = bh / 2 + curFont->height / 2- curFont->descent + offsetsY[offsetYIndex];
-        if (curFont->xft_ft) {
-            // Para Xft usa la versión de 32 bits que soporta tus iconos grandes
-            XftDrawString32(xftDraw, &selFg, curFont->xft_ft, x, y, (const FcChar32 *)&ch, 1);
+    // Dibuja un run de caracteres que comparten fuente con un único request.
+    // Las posiciones salen de los anchos ya medidos, así el resultado es
+    // idéntico a dibujar carácter por carácter.
+    void drawRun(monitor_t* mon, int fontSlot, int x,
+                 const uint32_t* ucs, const uint8_t* widths, int len) {
+        font_t *curFont = fontList[fontSlot];
+        int y = bh / 2 + curFont->height / 2 - curFont->descent + offsetsY[fontSlot];
+
+        if (curFont->xft_ft && renderBackend == RENDER_SHM) {
+            shm.drawGlyphs(fontSlot, curFont->xft_ft, x, y, ucs, widths, len, foregroundColor.v);
+        } else if (curFont->xft_ft && renderBackend == RENDER_XRENDER) {
+            xrender.drawGlyphs(mon->pixmap, fontSlot, x, y, ucs, len, foregroundColor.v);
+        } else if (curFont->xft_ft) {
+            XftCharSpec specs[MAX_RUN_LEN];
+            for (int i = 0; i < len; i++) {
+                specs[i].ucs4 = ucs[i];
+                specs[i].x = x;
+                specs[i].y = y;
+                x += widths[i];
+            }
+            XftDrawCharSpec(xftDraw, &selFg, curFont->xft_ft, specs, len);
         } else {
-            // Para XCB, solo si el icono cabe en 16 bits
-            if (ch <= 0xFFFF) {
-                uint16_t ch16 = (uint16_t)ch;
+            // Para XCB, solo los caracteres que caben en 16 bits
+            uint16_t chars[MAX_RUN_LEN];
+            int n = 0;
+            for (int i = 0; i < len; i++) {
+                if (ucs[i] > 0xFFFF)
+                    continue;
+                uint16_t ch16 = (uint16_t)ucs[i];
                 // XCB requiere Big Endian para texto de 16 bits, hay que swappear
-                ch16 = (ch16 >> 8) | (ch16 << 8);
-                xcb_poly_text_16_simple(c, mon->pixmap, gc[GC_DRAW], x, y, 1, &ch16);
+                chars[n++] = (ch16 >> 8) | (ch16 << 8);
             }
+            xcb_change_gc(c, gc[GC_DRAW], XCB_GC_FONT, (const uint32_t []){ curFont->ptr });
+            xcb_poly_text_16_simple(c, mon->pixmap, gc[GC_DRAW], x, y, n, chars);
         }
+    }
 
-        drawLines(mon, x, chWidth);
+    // Parte el texto en runs máximos de caracteres con la misma fuente. La
+    // fuente de cada carácter ya fue resuelta en parseElementContent.
+    void drawText(monitor_t* mon, int x, const uint32_t* ucs, const uint8_t* widths,
+                  const uint8_t* fontSlots, int len) {
+        if (!fontCount)
+            return;
 
-        return chWidth;
-    }
+        int i = 0;
+        while (i < len) {
+            uint8_t runSlot = fontSlots[i];
+            int runWidth = widths[i];
+            int j = i + 1;
+            while (j < len && j - i < MAX_RUN_LEN && fontSlots[j] == runSlot) {
+                runWidth += widths[j];
+                j++;
+            }
 
+            drawRun(mon, runSlot, x, ucs + i, widths + i, j - i);
+            x += runWidth;
+            i = j;
+        }
+    }
 
     void setAttribute(const char modifier, const char attribute) {
         int pos = indexof(attribute, "ou");
 
         if (pos < 0) {
-            fprintf(stderr, "Invalid attribute \"%c\" found\n", attribute);
+            LOG_WARN("Invalid attribute \"%c\" found", attribute);
             return;
         }
 
@@ -540,33 +870,85 @@ public:
         return true;
     }
 
-    font_t *
-    selectDrawableFont (const uint32_t c)
+    int
+    lookupFontSlot (const uint32_t c)
     {
         // If the user has specified a font to use, try that first.
-        if (fontIndex != -1 && fontHasGlyph(fontList[fontIndex - 1], c)) {
-            offsetYIndex = fontIndex - 1;
-            return fontList[fontIndex - 1];
-        }
+        if (fontIndex != -1 && fontHasGlyph(fontList[fontIndex - 1], c))
+            return fontIndex - 1;
 
-        // If the end is reached without finding an appropriate font, return NULL.
-        // If the font can draw the character, return it.
+        // If the end is reached without finding an appropriate font, return -1.
         for (int i = 0; i < fontCount; i++) {
-            if (fontHasGlyph(fontList[i], c)) {
-                offsetYIndex = i;
-                return fontList[i];
+            if (fontHasGlyph(fontList[i], c))
+                return i;
+        }
+        return -1;
+    }
+
+    // Índice en fontList de la fuente que dibuja c, o -1 si ninguna lo tiene.
+    // El resultado se cachea: tabla plana para el BMP y hash para los planos
+    // suplementarios (iconos Nerd Font en U+F0000+). Solo se invalida al
+    // cargar fuentes.
+    int
+    fontSlotFor (const uint32_t c)
+    {
+        uint8_t cached;
+        if (c < 0x10000) {
+            cached = bmpFontSlots[c];
+            if (!cached) {
+                int slot = lookupFontSlot(c);
+                cached = bmpFontSlots[c] = (slot < 0) ? FONT_SLOT_NONE : slot + 1;
+            }
+        } else {
+            auto it = astralFontSlots.find(c);
+            if (it != astralFontSlots.end()) {
+                cached = it->second;
+            } else {
+                int slot = lookupFontSlot(c);
+                cached = (slot < 0) ? FONT_SLOT_NONE : slot + 1;
+                astralFontSlots.emplace(c, cached);
             }
         }
-        return NULL;
+        return (cached == FONT_SLOT_NONE) ? -1 : cached - 1;
+    }
+
+    void
+    fontSlotCacheClear (void)
+    {
+        memset(bmpFontSlots, 0, sizeof(display->bmpFontSlots));
+        astralFontSlots.clear();
+    }
+
+    // Resuelve la fuente de ucs; si ninguna lo tiene lo reemplaza por '?'.
+    // Devuelve siempre un índice válido en fontList.
+    int
+    resolveGlyph (uint32_t &ucs)
+    {
+        int slot = fontSlotFor(ucs);
+        if (slot < 0) {
+            ucs = '?';
+            slot = fontSlotFor(ucs);
+        }
+        return (slot < 0) ? 0 : slot;
+    }
+
+    font_t *
+    selectDrawableFont (const uint32_t c)
+    {
+        int slot = fontSlotFor(c);
+        if (slot < 0)
+            return NULL;
+        offsetYIndex = slot;
+        return fontList[slot];
     }
 
 
     void
     fontLoad (const char *pattern)
     {
-        fprintf(stderr, "[lemonbar] fontLoad: trying to load '%s' (fontCount=%d)\n", pattern ? pattern : "(null)", fontCount);
+        LOG_DEBUG("[lemonbar] fontLoad: trying to load '%s' (fontCount=%d)", pattern ? pattern : "(null)", fontCount);
         if (fontCount >= MAX_FONT_COUNT) {
-            fprintf(stderr, "Max font count reached. Could not load font \"%s\"\n", pattern);
+            LOG_ERROR("Max font count reached. Could not load font \"%s\"", pattern);
             return;
         }
 
@@ -575,11 +957,11 @@ public:
          * (useful for in-process use) while avoiding dereferencing a NULL
          * xcb_connection. */
         if (!dpy || !c) {
-            fprintf(stderr, "[lemonbar] fontLoad: no X connection, calling xconn()\n");
+            LOG_DEBUG("[lemonbar] fontLoad: no X connection, calling xconn()");
             xconn();
         }
 
-        fprintf(stderr, "[lemonbar] fontLoad: X connection present (dpy=%p c=%p)\n", (void*)dpy, (void*)c);
+        LOG_DEBUG("[lemonbar] fontLoad: X connection present (dpy=%p c=%p)", (void*)dpy, (void*)c);
         xcb_query_font_cookie_t queryreq;
         xcb_query_font_reply_t *font_info;
         xcb_void_cookie_t cookie;
@@ -613,23 +995,25 @@ public:
             free(font_info);
         } else if ((ret->xft_ft = XftFontOpenName (dpy, scrNbr, pattern))) {
             ret->ptr = 0;
+            ret->glyphs = new GlyphCache();
             ret->ascent = ret->xft_ft->ascent;
             ret->descent = ret->xft_ft->descent;
             ret->height = ret->ascent + ret->descent;
         } else {
-            fprintf(stderr, "Could not load font %s\n", pattern);
+            LOG_ERROR("Could not load font %s", pattern);
             free(ret);
             return;
         }
 
         fontList[fontCount++] = ret;
-        fprintf(stderr, "[lemonbar] fontLoad: loaded '%s' into slot %d\n", pattern, fontCount-1);
+        fontSlotCacheClear();
+        LOG_DEBUG("[lemonbar] fontLoad: loaded '%s' into slot %d", pattern, fontCount-1);
     }
 
 
     void addYOffset(int offset) {
         if (offsetYCount >= MAX_FONT_COUNT) {
-            fprintf(stderr, "Max offset count reached. Could not set offset \"%d\"\n", offset);
+            LOG_WARN("Max offset count reached. Could not set offset \"%d\"", offset);
             return;
         }
 
@@ -644,213 +1028,361 @@ public:
 
 
     void parseElementContent(BarElement* element) {
-        // Parsear contenido UTF-8 y calcular anchos si está dirty
-        if (!element->dirtyContent) return;
+        // Parsear contenido UTF-8 y calcular anchos si está dirty. Una copia
+        // recién publicada no tiene texto en el arena y también se parsea.
+        if (!element->dirtyContent && (element->text.capacity || !element->ucsContentLen)) return;
 
+        // Se corta en el terminador o en contentLen, lo que llegue antes
         char *p = element->content;
+        int contentLen = element->contentLen;
+        if (contentLen < 0) contentLen = 0;
+        if (contentLen > CONTENT_MAX_LEN - 1) contentLen = CONTENT_MAX_LEN - 1;
+        const char *end = element->content + contentLen;
         uint8_t char_width = 0;
         int total_width = 0;
+        int i = 0;
 
-        for (int i = 0; i < CONTENT_MAX_LEN; i++) {
-            if (*p == '\0' || *p == '\n') {
-                element->ucsContent[i] = '\0';
-                element->ucsContentLen = i;
+        for (; p < end; i++) {
+            if (*p == '\0' || *p == '\n')
                 break;
-            }
-
-            UTF8Result result = decodeUtf8Char(p);
 
-            font_t *curFont = selectDrawableFont(result.ucs);
-            if (!curFont) result.ucs = '?';
+            UTF8Result result = decodeUtf8Char(p, end - p);
 
-            char_width = getUtf8CharWidth(result.ucs, curFont);
+            int slot = resolveGlyph(result.ucs);
+            char_width = getUtf8CharWidth(result.ucs, fontList[slot]);
 
-            element->ucsContent[i] = result.ucs;
-            element->ucsContentCharWidths[i] = char_width;
+            parseUcs[i] = result.ucs;
+            parseFonts[i] = slot;
+            parseWidths[i] = char_width;
             total_width += char_width;
 
             p += result.bytesConsumed;
         }
 
-        element->width = total_width;
+        // Al arena solo va el largo real
+        textArena.reserve(element->text, i);
+        memcpy(textArena.ucs(element->text), parseUcs, i * sizeof(uint32_t));
+        memcpy(textArena.fonts(element->text), parseFonts, i);
+        memcpy(textArena.widths(element->text), parseWidths, i);
+        element->ucsContentLen = i;
+        element->visibleLen = i;
+
+        // El offset forma parte del rectángulo del elemento
+        element->width = element->offsetPixels + total_width;
+        element->fullWidth = element->width;
+        element->fitWidth = -1;
         element->dirtyContent = false;
     }
 
+    // Los colores se aplican en renderElement; en la fase de parseo solo se
+    // decodifica el contenido que haya cambiado.
     void parseLeftModules() {
-        int current_x = 0;
-        monitor_t* cur_mon = monhead;
+        monitor_t* cur_mon = primary;
 
         for (Module* module : leftModules) {
             module->window = cur_mon->window;
-
-            for (BarElement* element : module->getElements()) {
-                // Aplicar colores
-                bool colorsChanged = false;
-                if (element->backgroundColor != Color(0x00000000U)) {
-                    backgroundColor = element->backgroundColor;
-                    colorsChanged = true;
-                }
-                if (element->foregroundColor != Color(0x00000000U)) {
-                    foregroundColor = element->foregroundColor;
-                    colorsChanged = true;
-                }
-                if (element->underlineColor != Color(0x00000000U)) {
-                    underlineColor = element->underlineColor;
-                    colorsChanged = true;
-                }
-                if (colorsChanged) {
-                    markColorsDirty();
-                    updateGc();
-                }
-
-                // Parsear contenido y calcular anchos
+            for (BarElement* element : module->getElements())
                 parseElementContent(element);
-
-                // Posicionar de izquierda a derecha
-                element->beginX = current_x;
-                current_x += element->width;
-            }
         }
     }
 
     void parseRightModules() {
-        monitor_t* cur_mon = monhead;
+        monitor_t* cur_mon = primary;
 
-        // Calcular ancho total de todos los elementos derechos
-        int total_width = 0;
         for (Module* module : rightModules) {
             module->window = cur_mon->window;
-
-            for (BarElement* element : module->getElements()) {
-                // Aplicar colores
-                bool colorsChanged = false;
-                if (element->backgroundColor != Color(0x00000000U)) {
-                    backgroundColor = element->backgroundColor;
-                    colorsChanged = true;
-                }
-                if (element->foregroundColor != Color(0x00000000U)) {
-                    foregroundColor = element->foregroundColor;
-                    colorsChanged = true;
-                }
-                if (element->underlineColor != Color(0x00000000U)) {
-                    underlineColor = element->underlineColor;
-                    colorsChanged = true;
-                }
-                if (colorsChanged) {
-                    markColorsDirty();
-                    updateGc();
-                }
-
+            for (BarElement* element : module->getElements())
                 parseElementContent(element);
-                total_width += element->width;
-            }
-        }
-
-        // Posicionar elementos de derecha a izquierda
-        int current_x = cur_mon->width;
-        for (Module* module : rightModules) {
-            for (BarElement* element : module->getElements()) {
-                current_x -= element->width;
-                element->beginX = current_x;
-            }
         }
     }
 
     int renderSeparatorAt(monitor_t* cur_mon, int current_x) {
+        attrs = 0;
         backgroundColor = defaultBackgroundColor;
         foregroundColor = defaultForegroundColor;
         markColorsDirty();
         updateGc();
 
-        int pos_x = current_x;
-        font_t* lastFont = nullptr;
+        paintRect(cur_mon, GC_CLEAR, current_x, 0, separator.totalWidth, bh);
+        drawText(cur_mon, current_x, separator.ucs, separator.widths, separator.fontSlots, 2);
 
-        for (int i = 0; i < 2; i++) {
-            auto& chFont = separator.fonts[i];
-            if (chFont != lastFont) {
-                if (chFont->ptr)
-                    xcb_change_gc(c, gc[GC_DRAW], XCB_GC_FONT, (const uint32_t[]){chFont->ptr});
-                lastFont = chFont;
+        return current_x + separator.totalWidth;
+    }
+
+    // Copia el texto de los elementos vivos a un arena nuevo; lo que
+    // abandonaron los elementos que crecieron o desaparecieron queda atrás
+    void compactText() {
+        TextArena fresh;
+        for (Module* module : modules) {
+            BarElement* element;
+            for (size_t i = 0; (element = module->elementAt(i)); i++) {
+                if (element->text.capacity)
+                    textArena.moveTo(fresh, element->text, element->ucsContentLen);
             }
-            drawChar(cur_mon, chFont, pos_x, ALIGN_L, separator.ucs[i]);
-            pos_x += separator.widths[i];
+        }
+        textArena.swap(fresh);
+    }
+
+    // Recorta el elemento para que entre en maxWidth con los anchos por
+    // carácter que ya salieron del cache de glifos al parsear. El punto de
+    // corte se guarda y solo se recalcula si cambia el texto o el espacio.
+    void fitElement(BarElement* element, int maxWidth) {
+        if (maxWidth < 0) maxWidth = 0;
+        if (element->fitWidth == maxWidth) return;
+        element->fitWidth = maxWidth;
+
+        if (element->fullWidth <= maxWidth) {
+            element->visibleLen = element->ucsContentLen;
+            element->width = element->fullWidth;
+            return;
         }
 
-        return pos_x;
+        const uint8_t *widths = textArena.widths(element->text);
+        int w = element->offsetPixels + ellipsis.width;
+        int n = 0;
+        while (n < element->ucsContentLen && w + widths[n] <= maxWidth) {
+            w += widths[n];
+            n++;
+        }
+        // Si ni la elipsis entra, el elemento desaparece
+        if (w > maxWidth) {
+            n = 0;
+            w = 0;
+        }
+        element->visibleLen = n;
+        element->width = w;
     }
 
-    void renderAllElements() {
-        monitor_t* cur_mon = monhead;
+    // Calcula beginX de todos los elementos y la posición de cada separador,
+    // sin dibujar nada.
+    void layoutElements(monitor_t* cur_mon) {
+        separatorX.clear();
 
         // Margen derecho permanente (similar a CSS margin-right)
-        const int RIGHT_MARGIN = xftCharWidth(' ', selectDrawableFont(' '));
+        uint32_t space = ' ';
+        const int RIGHT_MARGIN = getUtf8CharWidth(space, fontList[resolveGlyph(space)]);
         int available_width = cur_mon->width - RIGHT_MARGIN;
 
-        // Renderizar elementos izquierdos con separadores
-        int current_x = 0;
+        // Elementos derechos primero: su ancho define el espacio libre
+        int total_right_width = 0;
+        for (Module* module : rightModules) {
+            for (BarElement* element : module->getElements()) {
+                total_right_width += element->width;
+            }
+        }
+
+        int right_separator_count = (rightModules.size() > 0) ? (rightModules.size() - 1) : 0;
+        int right_x = available_width - total_right_width - right_separator_count * separator.totalWidth;
+
+        // El primer elemento izquierdo con truncate se queda con lo que sobra,
+        // dejando un separador de aire antes de los derechos
+        BarElement* fill = nullptr;
+        int fixed_left_width = 0;
         for (size_t i = 0; i < leftModules.size(); i++) {
-            Module* module = leftModules[i];
+            for (BarElement* element : leftModules[i]->getElements()) {
+                if (element->truncate && !fill)
+                    fill = element;
+                else
+                    fixed_left_width += element->width;
+            }
+            if (i < leftModules.size() - 1)
+                fixed_left_width += separator.totalWidth;
+        }
+        if (fill)
+            fitElement(fill, right_x - separator.totalWidth - fixed_left_width);
 
-            // Renderizar todos los elementos del módulo actual
-            for (BarElement* element : module->getElements()) {
+        // Elementos izquierdos con separadores
+        int current_x = 0;
+        for (size_t i = 0; i < leftModules.size(); i++) {
+            for (BarElement* element : leftModules[i]->getElements()) {
                 element->beginX = current_x;
-                renderElement(element, cur_mon);
                 current_x += element->width;
             }
 
             // Agregar separador excepto después del último módulo
             if (i < leftModules.size() - 1) {
-                current_x = renderSeparatorAt(cur_mon, current_x);
+                separatorX.push_back(current_x);
+                current_x += separator.totalWidth;
             }
         }
+        leftEnd = current_x;
+        rightStart = right_x;
 
-        // Renderizar elementos derechos con márgen
-        // Calcular ancho total de elementos derechos
-        int total_right_width = 0;
-        for (Module* module : rightModules) {
-            for (BarElement* element : module->getElements()) {
-                total_right_width += element->width;
+        // Elementos derechos, alineados contra el margen derecho
+        current_x = right_x;
+
+        for (size_t i = 0; i < rightModules.size(); i++) {
+            for (BarElement* element : rightModules[i]->getElements()) {
+                element->beginX = current_x;
+                current_x += element->width;
             }
-        }
 
-        // Ancho total de separadores derechos
-        int right_separator_count = (rightModules.size() > 0) ? (rightModules.size() - 1) : 0;
-        int separator_width = 0;
+            if (i < rightModules.size() - 1) {
+                separatorX.push_back(current_x);
+                current_x += separator.totalWidth;
+            }
+        }
 
-        // Calcular ancho del separador UTF-8 usando funciones helper
-        const char* sep_string = " ▏";
-        separator_width = 0;
+        buildHitIndex();
+    }
 
-        const char* p = sep_string;
-        while (*p != '\0') {
-            UTF8Result result = decodeUtf8Char(p);
-            font_t *curFont = selectDrawableFont(result.ucs);
-            if (curFont) {
-                separator_width += getUtf8CharWidth(result.ucs, curFont);
+    void addHitSpans(const std::vector<Module*> &side) {
+        for (Module* module : side) {
+            BarElement* element;
+            for (size_t i = 0; (element = module->elementAt(i)); i++) {
+                if (element->width == 0 || element->events.empty())
+                    continue;
+                hitIndex.push_back({element->beginX, element->beginX + element->width, module, i});
             }
-            p += result.bytesConsumed;
         }
+    }
 
-        int total_right_with_separators = total_right_width + (right_separator_count * separator_width);
+    // Los izquierdos y luego los derechos ya salen en orden; solo una barra
+    // desbordada (derechos pisando a los izquierdos) necesita ordenar
+    void buildHitIndex() {
+        hitIndex.clear();
+        addHitSpans(leftModules);
+        addHitSpans(rightModules);
+        auto byX = [](const HitSpan& a, const HitSpan& b) { return a.x0 < b.x0; };
+        if (!std::is_sorted(hitIndex.begin(), hitIndex.end(), byX))
+            std::stable_sort(hitIndex.begin(), hitIndex.end(), byX);
+    }
 
-        // Posicionar elementos derechos respetando el margen derecho
-        current_x = available_width - total_right_with_separators;
+    // Elemento bajo x (coordenadas del layout), nullptr si no hay ninguno
+    BarElement* hitTest(int x) {
+        auto it = std::upper_bound(hitIndex.begin(), hitIndex.end(), x,
+                                   [](int x, const HitSpan& span) { return x < span.x0; });
+        if (it == hitIndex.begin())
+            return nullptr;
+        --it;
+        if (x >= it->x1)
+            return nullptr;
+
+        BarElement* element = it->module->elementAt(it->index);
+        if (!element || element->beginX != it->x0)
+            return nullptr;
+        return element;
+    }
 
-        for (size_t i = 0; i < rightModules.size(); i++) {
-            Module* module = rightModules[i];
+    void addDamage(int x, int w) {
+        if (w <= 0) return;
+        damage.push_back({x, x + w});
+    }
 
-            // Renderizar elementos del módulo actual
+    // Limpia un tramo con el color de fondo por defecto
+    void clearSpan(monitor_t* cur_mon, int x, int w) {
+        if (w <= 0) return;
+        if (backgroundColor != defaultBackgroundColor) {
+            backgroundColor = defaultBackgroundColor;
+            markColorsDirty();
+            updateGc();
+        }
+        paintRect(cur_mon, GC_CLEAR, x, 0, w, bh);
+        addDamage(x, w);
+    }
+
+    // Ordena y fusiona los tramos dañados para copiar cada píxel una sola vez
+    void mergeDamage() {
+        if (damage.size() < 2) return;
+        std::sort(damage.begin(), damage.end(),
+                  [](const DamageSpan& a, const DamageSpan& b) { return a.x0 < b.x0; });
+        size_t out = 0;
+        for (size_t i = 1; i < damage.size(); i++) {
+            if (damage[i].x0 <= damage[out].x1) {
+                damage[out].x1 = max(damage[out].x1, damage[i].x1);
+            } else {
+                damage[++out] = damage[i];
+            }
+        }
+        damage.resize(out + 1);
+    }
+
+    // Redibuja solo los elementos cuyo contenido, estilo o posición cambió.
+    // Primero se limpian todas las áreas viejas y luego se dibujan las nuevas,
+    // así un elemento que se movió no pisa a un vecino ya redibujado.
+    void renderAllElements() {
+        monitor_t* cur_mon = primary;
+
+        dirtyElements.clear();
+
+        liveElements.clear();
+        for (Module* module : modules)
+            for (BarElement* element : module->getElements())
+                liveElements.push_back(element);
+        std::sort(liveElements.begin(), liveElements.end());
+
+        // Áreas de elementos que ya no existen. Un puntero que sigue vivo
+        // pero sin drawn es otro elemento que reusó la dirección.
+        if (!fullRedraw) {
+            for (const DrawnExtent& extent : drawnExtents) {
+                if (!std::binary_search(liveElements.begin(), liveElements.end(), extent.element) ||
+                    !extent.element->drawn)
+                    clearSpan(cur_mon, extent.x, extent.width);
+            }
+        }
+
+        if (fullRedraw) {
+            drawnSeparatorX.clear();
+            clearSpan(cur_mon, 0, cur_mon->width);
+        }
+
+        for (Module* module : modules) {
             for (BarElement* element : module->getElements()) {
-                element->beginX = current_x;
-                renderElement(element, cur_mon);
-                current_x += element->width;
+                uint32_t hash = element->renderHash();
+                if (!fullRedraw && element->drawn &&
+                    element->drawnHash == hash &&
+                    element->drawnX == element->beginX &&
+                    element->drawnWidth == element->width)
+                    continue;
+
+                if (element->drawn && !fullRedraw)
+                    clearSpan(cur_mon, element->drawnX, element->drawnWidth);
+
+                element->drawnHash = hash;
+                dirtyElements.push_back(element);
             }
+        }
 
-            // Agregar separador excepto después del último módulo
-            if (i < rightModules.size() - 1) {
-                current_x = renderSeparatorAt(cur_mon, current_x);
+        bool separatorsMoved = (separatorX != drawnSeparatorX);
+        if (separatorsMoved) {
+            for (int x : drawnSeparatorX)
+                clearSpan(cur_mon, x, separator.totalWidth);
+        }
+
+        // Sin nada que dibujar ni áreas limpiadas, el frame no cambia
+        if (dirtyElements.empty() && !separatorsMoved && damage.empty())
+            return;
+
+        for (BarElement* element : dirtyElements) {
+            renderElementCached(element, cur_mon);
+            addDamage(element->beginX, element->width);
+
+            element->drawnX = element->beginX;
+            element->drawnWidth = element->width;
+            element->drawn = true;
+        }
+
+        drawnExtents.clear();
+        for (BarElement* element : liveElements)
+            if (element->drawn)
+                drawnExtents.push_back({element, element->drawnX, element->drawnWidth});
+
+        // Un elemento limpiado puede haber tapado un separador que no se movió
+        for (size_t i = 0; i < separatorX.size(); i++) {
+            int x = separatorX[i];
+            bool redraw = separatorsMoved;
+            for (const DamageSpan& d : damage) {
+                if (x < d.x1 && x + separator.totalWidth > d.x0) {
+                    redraw = true;
+                    break;
+                }
+            }
+            if (redraw) {
+                renderSeparatorAt(cur_mon, x);
+                addDamage(x, separator.totalWidth);
             }
         }
+        drawnSeparatorX = separatorX;
     }
 
     void renderElement(BarElement* element, monitor_t* cur_mon) {
@@ -891,75 +1423,302 @@ public:
             updateGc();
         }
 
-        // Usar posición pre-calculada en beginX
+        if (element->overline)
+            attrs |= ATTR_OVERL;
+
+        // Fondo y líneas una vez por elemento, texto una vez por run
         int pos_x = element->beginX;
+        paintRect(cur_mon, GC_CLEAR, pos_x, 0, element->width, bh);
+        drawText(cur_mon, pos_x + element->offsetPixels,
+                 textArena.ucs(element->text), textArena.widths(element->text),
+                 textArena.fonts(element->text), element->visibleLen);
+        if (element->visibleLen < element->ucsContentLen && element->width > 0) {
+            drawText(cur_mon, pos_x + element->width - ellipsis.width,
+                     &ellipsis.ucs, &ellipsis.width, &ellipsis.fontSlot, 1);
+        }
+        drawLines(cur_mon, pos_x, element->width);
+    }
+
+    static uint64_t renderCacheKey(const BarElement* element, uint32_t hash) {
+        return (uint64_t)hash << 32 | (uint64_t)element->width << 16 | (uint16_t)element->ucsContentLen;
+    }
 
-        // Aplicar offset si existe
-        if (element->offsetPixels > 0) {
-            drawShift(cur_mon, pos_x, ALIGN_L, element->offsetPixels);
-            pos_x += element->offsetPixels;
+    void renderCacheErase(std::unordered_map<uint64_t, CachedRender>::iterator it) {
+        xrender.releaseDrawable(it->second.pixmap);
+        xcb_free_pixmap(c, it->second.pixmap);
+        renderCacheBytes -= it->second.bytes;
+        renderLru.erase(it->second.lru);
+        renderCache.erase(it);
+    }
+
+    void renderCacheEvict(void) {
+        while (renderCacheBytes > renderCacheLimit && renderLru.size() > 1) {
+            renderCacheErase(renderCache.find(renderLru.back()));
+            renderCacheEvictions++;
         }
+    }
 
-        // Renderizar cada carácter del elemento
-        for (int i = 0; i < element->ucsContentLen; i++) {
-            uint32_t ucs = element->ucsContent[i];
-            font_t *curFont = selectDrawableFont(ucs);
+    void renderCacheClear(void) {
+        for (auto& entry : renderCache) {
+            xrender.releaseDrawable(entry.second.pixmap);
+            xcb_free_pixmap(c, entry.second.pixmap);
+        }
+        renderCache.clear();
+        renderLru.clear();
+        renderCacheBytes = 0;
+    }
 
-            // Hot fix: Si no hay font válida, usar la primera disponible
-            if (!curFont) {
-                if (fontCount > 0) {
-                    curFont = fontList[0];
-                } else {
-                    // Si no hay ninguna font, skip este carácter
-                    continue;
+    // Dibuja el elemento copiándolo del cache si ya fue rasterizado con el
+    // mismo contenido y estilo. Si no, la primera vez lo dibuja directo y la
+    // segunda lo rasteriza en su propio pixmap.
+    void renderElementCached(BarElement* element, monitor_t* cur_mon) {
+        if (element->width == 0)
+            return;
+
+        // En memoria volver a rasterizar es más barato que mantener copias
+        if (renderBackend == RENDER_SHM) {
+            renderElement(element, cur_mon);
+            return;
+        }
+
+        uint64_t key = renderCacheKey(element, element->drawnHash);
+        auto it = renderCache.find(key);
+
+        // Misma clave pero otro contenido: la entrada vieja se descarta
+        if (it != renderCache.end() && !it->second.matches(element)) {
+            renderCacheErase(it);
+            it = renderCache.end();
+        }
+
+        if (it != renderCache.end()) {
+            renderCacheHits++;
+            renderLru.splice(renderLru.begin(), renderLru, it->second.lru);
+        } else {
+            renderCacheMisses++;
+
+            // Primera vez que aparece: dibujo directo, sin cachear
+            uint64_t& seen = renderSeen[(key ^ key >> 29) % RENDER_SEEN_SLOTS];
+            if (seen != key) {
+                seen = key;
+                renderElement(element, cur_mon);
+                return;
+            }
+
+            CachedRender entry;
+            entry.pixmap = xcb_generate_id(c);
+            entry.bytes = element->width * bh * 4;
+            xcb_create_pixmap(c, visualDepth, entry.pixmap, cur_mon->window, element->width, bh);
+
+            // Superficie temporal con la forma de un monitor para reutilizar renderElement
+            monitor_t surface = {};
+            surface.width = element->width;
+            surface.window = cur_mon->window;
+            surface.pixmap = entry.pixmap;
+
+            XftDraw *monitorDraw = xftDraw;
+            if (renderBackend == RENDER_XFT) {
+                xftDraw = XftDrawCreate(dpy, entry.pixmap, visualPtr, colormap);
+                if (!xftDraw) {
+                    LOG_ERROR("Couldn't create xft drawable");
+                    xftDraw = monitorDraw;
+                    xcb_free_pixmap(c, entry.pixmap);
+                    renderElement(element, cur_mon);
+                    return;
                 }
             }
 
-            if (curFont->ptr) {
-                xcb_change_gc(c, gc[GC_DRAW] , XCB_GC_FONT,
-                              (const uint32_t []) { curFont->ptr });
+            uint16_t beginX = element->beginX;
+            element->beginX = 0;
+            renderElement(element, &surface);
+            element->beginX = beginX;
+
+            if (renderBackend == RENDER_XFT) {
+                XftDrawDestroy(xftDraw);
+                xftDraw = monitorDraw;
             }
 
-            drawChar(cur_mon, curFont, pos_x, ALIGN_L, ucs);
-            pos_x += element->ucsContentCharWidths[i];
+            entry.content.assign(element->content, element->renderedLen());
+            element->styleWords(entry.style);
+            entry.visibleLen = element->visibleLen;
+
+            renderLru.push_front(key);
+            entry.lru = renderLru.begin();
+            it = renderCache.emplace(key, entry).first;
+            renderCacheBytes += entry.bytes;
         }
 
+        xcb_copy_area(c, it->second.pixmap, cur_mon->pixmap, gc[GC_DRAW],
+                      0, 0, element->beginX, 0, element->width, bh);
 
+        renderCacheEvict();
     }
 
     void parseModules() {
         // === INICIALIZACIÓN ===
-        monitor_t* cur_mon = monhead;
+        monitor_t* cur_mon = primary;
+        damage.clear();
 
-        // === LIMPIEZA DE MONITORES ===
-        for (monitor_t *m = monhead; m != NULL; m = m->next)
-            fillRect(m->pixmap, gc[GC_CLEAR], 0, 0, m->width, bh);
+        // === PROCESAMIENTO SIMPLIFICADO ===
+        int64_t start = Stats::nowNs();
+        parseLeftModules();
+        parseRightModules();
+        if (textArena.needsCompaction())
+            compactText();
+        layoutElements(cur_mon);
+        int64_t laidOut = Stats::nowNs();
+        stats->layout.record(laidOut - start);
 
         // === CREACIÓN DEL DRAWABLE XFT ===
-        if (!(xftDraw = XftDrawCreate (dpy, cur_mon->pixmap, visualPtr , colormap))) {
-            fprintf(stderr, "Couldn't create xft drawable\n");
+        if (renderBackend == RENDER_XFT &&
+            !(xftDraw = XftDrawCreate (dpy, cur_mon->pixmap, visualPtr , colormap))) {
+            LOG_ERROR("Couldn't create xft drawable");
             return;
         }
 
-        // === PROCESAMIENTO SIMPLIFICADO ===
-        parseLeftModules();
-        parseRightModules();
-
-        // === RENDERIZADO ===
+        // === RENDERIZADO (solo lo que cambió) ===
         renderAllElements();
+        fullRedraw = false;
+        stats->raster.record(Stats::nowNs() - laidOut);
 
         // === LIMPIEZA FINAL ===
-        XftDrawDestroy(xftDraw);
+        if (renderBackend == RENDER_XFT)
+            XftDrawDestroy(xftDraw);
     }
 
     void feed() {
         parseModules();
+        if (damage.empty()) {
+            stats->framesSkipped.fetch_add(1, std::memory_order_relaxed);
+            publishStats();
+            return;
+        }
+
+        int64_t start = Stats::nowNs();
+        mergeDamage();
+
+        // En modo shm el frame está en el buffer del cliente: un solo put que
+        // cubre todos los tramos dañados lo lleva al pixmap
+        if (renderBackend == RENDER_SHM)
+            shm.present(primary->pixmap, gc[GC_DRAW], visualDepth,
+                        damage.front().x0, damage.back().x1);
 
-        // Copy pixmap to windows
+        // El frame se dibujó una sola vez en el primario. Cada monitor del
+        // mismo ancho cuesta una copia por tramo dañado; uno más ancho se arma
+        // con copias de las dos secciones.
+        bool recompose = leftEnd != composedLeftEnd || rightStart != composedRightStart;
         for (monitor_t *mon = monhead; mon; mon = mon->next) {
-            xcb_copy_area(c, mon->pixmap, mon->window, gc[GC_DRAW], 0, 0, 0, 0, mon->width, bh);
+            if (mon->source != mon || mon == primary) {
+                for (const DamageSpan& d : damage) {
+                    int x0 = d.x0 < 0 ? 0 : d.x0;
+                    int x1 = d.x1 > mon->width ? mon->width : d.x1;
+                    if (x1 > x0)
+                        xcb_copy_area(c, mon->source->pixmap, mon->window, gc[GC_DRAW], x0, 0, x0, 0, x1 - x0, bh);
+                }
+            } else {
+                composeMonitor(mon, recompose);
+            }
         }
+        composedLeftEnd = leftEnd;
+        composedRightStart = rightStart;
+        publishStats();
         xcb_flush(c);
+        stats->present.record(Stats::nowNs() - start);
+        stats->frames.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Vuelca a las stats lo que la barra cuenta sin atómicos (caches) y los
+    // requests de X. Estos salen de un NoOp al final de cada frame: lo que se
+    // mandó entre dos NoOp (frames, exposes, RandR) es la diferencia de
+    // secuencias menos el propio marcador.
+    void publishStats(void) {
+        stats->renderCacheHits.store(renderCacheHits, std::memory_order_relaxed);
+        stats->renderCacheMisses.store(renderCacheMisses, std::memory_order_relaxed);
+
+        uint64_t hits = 0, misses = 0;
+        for (int i = 0; i < fontCount; i++) {
+            if (fontList[i]->glyphs) {
+                hits += fontList[i]->glyphs->hits;
+                misses += fontList[i]->glyphs->misses;
+            }
+        }
+        Stats& global = Stats::instance();
+        global.glyphHits.store(hits, std::memory_order_relaxed);
+        global.glyphMisses.store(misses, std::memory_order_relaxed);
+
+        unsigned int sequence = xcb_no_operation(c).sequence;
+        if (display->statsSequence)
+            global.xRequests.fetch_add(sequence - display->statsSequence - 1, std::memory_order_relaxed);
+        display->statsSequence = sequence;
+    }
+
+    // Elige el primario y la fuente de cada monitor. Se llama cada vez que
+    // cambia la cadena de monitores.
+    void assignMonitorSources(void) {
+        primary = monhead;
+        for (monitor_t *mon = monhead; mon; mon = mon->next) {
+            if (mon->width < primary->width)
+                primary = mon;
+        }
+        for (monitor_t *mon = monhead; mon; mon = mon->next)
+            mon->source = (mon->width == primary->width) ? primary : mon;
+        composedLeftEnd = composedRightStart = -1;
+    }
+
+    // Arma un monitor más ancho que el primario sin rasterizar nada: la
+    // sección izquierda queda en su lugar, la derecha se corre contra el
+    // borde y el hueco del medio es fondo. Con las secciones quietas solo se
+    // copian los tramos dañados.
+    void composeMonitor(monitor_t *mon, bool full) {
+        int shift = mon->width - primary->width;
+
+        if (full) {
+            if (backgroundColor != defaultBackgroundColor) {
+                backgroundColor = defaultBackgroundColor;
+                markColorsDirty();
+                updateGc();
+            }
+            fillRect(mon->pixmap, gc[GC_CLEAR], leftEnd, 0, rightStart + shift - leftEnd, bh);
+            xcb_copy_area(c, primary->pixmap, mon->pixmap, gc[GC_DRAW], 0, 0, 0, 0, leftEnd, bh);
+            xcb_copy_area(c, primary->pixmap, mon->pixmap, gc[GC_DRAW], rightStart, 0,
+                          rightStart + shift, 0, primary->width - rightStart, bh);
+            xcb_copy_area(c, mon->pixmap, mon->window, gc[GC_DRAW], 0, 0, 0, 0, mon->width, bh);
+            return;
+        }
+
+        for (const DamageSpan& d : damage) {
+            int x0 = max(d.x0, 0);
+            int x1 = min(d.x1, leftEnd);
+            if (x1 > x0) {
+                xcb_copy_area(c, primary->pixmap, mon->pixmap, gc[GC_DRAW], x0, 0, x0, 0, x1 - x0, bh);
+                xcb_copy_area(c, mon->pixmap, mon->window, gc[GC_DRAW], x0, 0, x0, 0, x1 - x0, bh);
+            }
+            x0 = max(d.x0, rightStart);
+            x1 = min(d.x1, primary->width);
+            if (x1 > x0) {
+                xcb_copy_area(c, primary->pixmap, mon->pixmap, gc[GC_DRAW], x0, 0, x0 + shift, 0, x1 - x0, bh);
+                xcb_copy_area(c, mon->pixmap, mon->window, gc[GC_DRAW], x0 + shift, 0, x0 + shift, 0, x1 - x0, bh);
+            }
+        }
+    }
+
+    // Pasa una x de la ventana de un monitor a coordenadas del layout; -1 si
+    // cae en el hueco de un monitor más ancho
+    int layoutX(xcb_window_t window, int x) {
+        for (monitor_t *mon = monhead; mon; mon = mon->next) {
+            if (mon->window != window)
+                continue;
+            if (mon->source != mon || mon == primary)
+                return x;
+            int shift = mon->width - primary->width;
+            if (x >= rightStart + shift)
+                return x - shift;
+            return (x < leftEnd) ? x : -1;
+        }
+        return -1;
+    }
+
+    BarStats *getStats(void) {
+        return stats;
     }
 
     int getXcbFd(void) {
@@ -967,62 +1726,129 @@ public:
         return xcb_get_file_descriptor(c);
     }
 
-    void processXEvents(void) {
-        fprintf(stderr, "[lemonbar] lemonbar_process_xevents: polling events\n");
+    bool ownsWindow(xcb_window_t window) {
+        for (monitor_t *mon = monhead; mon; mon = mon->next) {
+            if (mon->window == window)
+                return true;
+        }
+        return false;
+    }
+
+    // Lee los eventos pendientes de la conexión compartida y le pasa cada
+    // uno a la barra dueña de la ventana
+    static void processXEvents(const std::vector<Bar*> &bars) {
+        if (bars.empty())
+            return;
+
+        LOG_TRACE("[lemonbar] lemonbar_process_xevents: polling events");
+        xcb_connection_t *conn = bars[0]->c;
         xcb_generic_event_t *ev;
-        bool redraw = false;
 
-        while ((ev = xcb_poll_for_event(c))) {
-            xcb_expose_event_t *expose_ev = (xcb_expose_event_t *)ev;
-            switch (ev->response_type & 0x7F) {
+        // Los eventos de RandR son de la pantalla, no de una ventana: valen
+        // para todas las barras. Una ráfaga (docking) se aplica una vez.
+        const xcb_query_extension_reply_t *randr = xcb_get_extension_data(conn, &xcb_randr_id);
+        bool outputsChanged = false;
+
+        while ((ev = xcb_poll_for_event(conn))) {
+            uint8_t type = ev->response_type & 0x7F;
+            if (randr && randr->present &&
+                (type == randr->first_event + XCB_RANDR_SCREEN_CHANGE_NOTIFY ||
+                 type == randr->first_event + XCB_RANDR_NOTIFY)) {
+                outputsChanged = true;
+                free(ev);
+                continue;
+            }
+
+            // Fin de un put de shm: libera el buffer de esa barra
+            bool shmDone = false;
+            for (Bar *bar : bars) {
+                if (bar->renderBackend == RENDER_SHM && bar->shm.handleCompletion(ev)) {
+                    shmDone = true;
+                    break;
+                }
+            }
+            if (shmDone) {
+                free(ev);
+                continue;
+            }
+
+            xcb_window_t window = XCB_NONE;
+            switch (type) {
                 case XCB_EXPOSE:
-                    fprintf(stderr, "[lemonbar] event: EXPOSE count=%d, processingExpose=%s\n", expose_ev->count, processingExpose ? "true" : "false");
-                    // Skip EXPOSE events that we generated ourselves to prevent infinite loop
-                    if (expose_ev->count == 0 && !processingExpose) {
-                        redraw = true;
-                    }
+                    window = ((xcb_expose_event_t *)ev)->window;
                     break;
-                case XCB_BUTTON_PRESS: {
-                    xcb_button_press_event_t *press_ev = (xcb_button_press_event_t *)ev;
-                    fprintf(stderr, "[lemonbar] event: BUTTON_PRESS win=%u detail=%u x=%u\n", press_ev->event, press_ev->detail, press_ev->event_x);
-
-                    bool eventHandled = false;
-                    for (Module *module : modules) {
-                        if (eventHandled) break;
-                        for (BarElement *element : module->getElements()) {
-                            if (eventHandled) break;
-                            for (std::pair<BarElement::EventType, EventFunction> pair : element->events) {
-                                if (pair.first != (const int)press_ev->detail)
-                                    continue;
-                                if (
-                                    module->window == press_ev->event &&
-                                    ((const int)press_ev->event_x) >= element->beginX &&
-                                    ((const int)press_ev->event_x) < (element->beginX + element->width)
-                                ) {
-                                    pair.second();
-                                    eventHandled = true;
-                                    break;
-                                }
-                            }
-                        }
-                    }
+                case XCB_BUTTON_PRESS:
+                    window = ((xcb_button_press_event_t *)ev)->event;
+                    break;
+            }
+            for (Bar *bar : bars) {
+                if (bar->ownsWindow(window)) {
+                    bar->handleXEvent(ev);
                     break;
                 }
             }
             free(ev);
         }
 
-        if (redraw) {
-            fprintf(stderr, "[lemonbar] lemonbar_process_xevents: redraw requested\n");
-            // Set flag to prevent infinite EXPOSE loop when we redraw
-            processingExpose = true;
-            for (monitor_t *mon = monhead; mon; mon = mon->next) {
-                xcb_copy_area(c, mon->pixmap, mon->window, gc[GC_DRAW], 0, 0, 0, 0, mon->width, bh);
+        if (outputsChanged) {
+            for (Bar *bar : bars) {
+                bar->updateMonitors();
+                bar->feed();
             }
-            xcb_flush(c);
-            // Clear the flag after flush is complete
-            processingExpose = false;
         }
+
+        for (Bar *bar : bars)
+            bar->flushExpose();
+    }
+
+    void processXEvents(void) {
+        processXEvents(std::vector<Bar*>(1, this));
+    }
+
+    void handleXEvent(xcb_generic_event_t *ev) {
+        xcb_expose_event_t *expose_ev = (xcb_expose_event_t *)ev;
+        switch (ev->response_type & 0x7F) {
+            case XCB_EXPOSE:
+                LOG_TRACE("[lemonbar] event: EXPOSE count=%d, processingExpose=%s", expose_ev->count, processingExpose ? "true" : "false");
+                // Skip EXPOSE events that we generated ourselves to prevent infinite loop
+                if (expose_ev->count == 0 && !processingExpose) {
+                    exposePending = true;
+                }
+                break;
+            case XCB_BUTTON_PRESS: {
+                xcb_button_press_event_t *press_ev = (xcb_button_press_event_t *)ev;
+                LOG_DEBUG("[lemonbar] event: BUTTON_PRESS win=%u detail=%u x=%u", press_ev->event, press_ev->detail, press_ev->event_x);
+
+                // Todos los monitores muestran el mismo layout
+                int x = layoutX(press_ev->event, press_ev->event_x);
+                if (x < 0)
+                    break;
+
+                BarElement *element = hitTest(x);
+                if (!element)
+                    break;
+                auto handler = element->events.find((BarElement::EventType)press_ev->detail);
+                if (handler != element->events.end())
+                    handler->second();
+                break;
+            }
+        }
+    }
+
+    void flushExpose(void) {
+        if (!exposePending)
+            return;
+        exposePending = false;
+
+        LOG_TRACE("[lemonbar] lemonbar_process_xevents: redraw requested");
+        // Set flag to prevent infinite EXPOSE loop when we redraw
+        processingExpose = true;
+        for (monitor_t *mon = monhead; mon; mon = mon->next) {
+            xcb_copy_area(c, mon->source->pixmap, mon->window, gc[GC_DRAW], 0, 0, 0, 0, mon->width, bh);
+        }
+        xcb_flush(c);
+        // Clear the flag after flush is complete
+        processingExpose = false;
     }
 
 
@@ -1037,8 +1863,9 @@ public:
         NET_WM_STATE_ABOVE,
     };
 
+    // Con only, solo para ese monitor (uno que apareció por hotplug)
     void
-    setEwmhAtoms (void)
+    setEwmhAtoms (monitor_t *only = NULL)
     {
         const char *atom_names[] = {
             "_NET_WM_WINDOW_TYPE",
@@ -1071,6 +1898,8 @@ public:
 
         // Prepare the strut array
         for (monitor_t *mon = monhead; mon; mon = mon->next) {
+            if (only && mon != only)
+                continue;
             int strut[12] = {0};
             if (topbar) {
                 strut[2] = bh;
@@ -1101,7 +1930,7 @@ public:
 
         ret = static_cast<monitor_t *>(calloc(1, sizeof(monitor_t)));
         if (!ret) {
-            fprintf(stderr, "Failed to allocate new monitor\n");
+            LOG_ERROR("Failed to allocate new monitor");
             exit(EXIT_FAILURE);
         }
 
@@ -1172,8 +2001,11 @@ public:
         return 0;
     }
 
-    void
-    monitorCreateChain (xcb_rectangle_t *rects, const int num)
+    // Geometría de las ventanas de la barra para un juego de outputs, con los
+    // argumentos de monitorNew: x, y del output, ancho de la ventana y alto
+    // del output. false si la barra no entra.
+    bool
+    monitorGeometry (xcb_rectangle_t *rects, const int num, std::vector<xcb_rectangle_t> &out)
     {
         int i;
         int width = 0, height = 0;
@@ -1191,8 +2023,8 @@ public:
                 height = h;
         }
 
-        if (bw < 0)
-            bw = width - bx;
+        // El ancho pedido se vuelve a derivar con cada juego de outputs
+        bw = (requestedBw < 0) ? width - bx : requestedBw;
 
         // Use the first font height as all the font heights have been set to the biggest of the set
         if (bh < 0 || bh > height)
@@ -1200,8 +2032,8 @@ public:
 
         // Check the geometry
         if (bx + bw > width || by + bh > height) {
-            fprintf(stderr, "The geometry specified doesn't fit the screen!\n");
-            exit(EXIT_FAILURE);
+            LOG_ERROR("The geometry specified doesn't fit the screen!");
+            return false;
         }
 
         // Left is a positive number or zero therefore monitors with zero width are excluded
@@ -1210,16 +2042,11 @@ public:
             if (rects[i].y + rects[i].height < by)
                 continue;
             if (rects[i].width > left) {
-                monitor_t *mon = monitorNew(
-                    rects[i].x + left,
+                out.push_back((xcb_rectangle_t){
+                    (int16_t)(rects[i].x + left),
                     rects[i].y,
-                    min(width, rects[i].width - left),
-                    rects[i].height);
-
-                if (!mon)
-                    break;
-
-                monitorAdd(mon);
+                    (uint16_t)min(width, rects[i].width - left),
+                    rects[i].height });
 
                 width -= rects[i].width - left;
                 // No need to check for other monitors
@@ -1232,10 +2059,130 @@ public:
             if (left < 0)
                 left = 0;
         }
+        return true;
+    }
+
+    void
+    monitorCreateChain (xcb_rectangle_t *rects, const int num)
+    {
+        std::vector<xcb_rectangle_t> geometry;
+        if (!monitorGeometry(rects, num, geometry))
+            exit(EXIT_FAILURE);
+
+        for (const xcb_rectangle_t &g : geometry)
+            monitorAdd(monitorNew(g.x, g.y, g.width, g.height));
+    }
+
+    void
+    monitorFree (monitor_t *mon)
+    {
+        xrender.releaseDrawable(mon->pixmap);
+        xcb_destroy_window(c, mon->window);
+        xcb_free_pixmap(c, mon->pixmap);
+        free(mon);
+    }
+
+    // Mapea la ventana del monitor con los atoms de nombre y clase
+    void
+    monitorShow (monitor_t *mon)
+    {
+        fillRect(mon->pixmap, gc[GC_CLEAR], 0, 0, mon->width, bh);
+        xcb_map_window(c, mon->window);
+
+        // Make sure that the window really gets in the place it's supposed to be
+        // Some WM such as Openbox need this
+        xcb_configure_window(c, mon->window, XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y, (const uint32_t []){ (uint32_t)mon->x, (uint32_t)mon->y });
+
+        // Set the WM_NAME atom to the user specified value
+        if (!wmName.empty())
+            xcb_change_property(c, XCB_PROP_MODE_REPLACE, mon->window, XCB_ATOM_WM_NAME, XCB_ATOM_STRING, 8, wmName.size(), wmName.c_str());
+
+        // set the WM_CLASS atom instance to the executable name
+        if (!wmInstance.empty()) {
+            // WM_CLASS is nullbyte seperated: wm_instance + "\0Bar\0"
+            std::string wm_class = wmInstance;
+            wm_class.append("\0Bar\0", 5);
+
+            xcb_change_property(c, XCB_PROP_MODE_REPLACE, mon->window, XCB_ATOM_WM_CLASS, XCB_ATOM_STRING, 8, wm_class.size(), wm_class.data());
+        }
     }
 
+    // Hotplug: compara la geometría nueva con la cadena actual. Un monitor
+    // que sigue igual conserva ventana y pixmap; solo se crean o destruyen
+    // los que cambiaron. Módulos, fuentes y caches de render no se tocan.
     void
-    getRandrMonitors (void)
+    monitorUpdateChain (xcb_rectangle_t *rects, const int num)
+    {
+        std::vector<xcb_rectangle_t> geometry;
+        if (!monitorGeometry(rects, num, geometry)) {
+            LOG_WARN("[randr] new output layout rejected, keeping the old one");
+            return;
+        }
+
+        // Ancho del primario antes de liberar nada: el viejo puede ser uno
+        // de los monitores que se destruyen abajo
+        int primaryWidth = primary ? primary->width : 0;
+
+        std::vector<monitor_t *> old;
+        for (monitor_t *mon = monhead; mon; mon = mon->next)
+            old.push_back(mon);
+
+        monhead = montail = NULL;
+        int created = 0, kept = 0;
+        for (const xcb_rectangle_t &g : geometry) {
+            int y = (topbar ? by : g.height - bh - by) + g.y;
+            monitor_t *mon = NULL;
+            for (monitor_t *&candidate : old) {
+                if (candidate && candidate->x == g.x && candidate->y == y && candidate->width == g.width) {
+                    mon = candidate;
+                    candidate = NULL;
+                    break;
+                }
+            }
+
+            if (mon) {
+                mon->prev = mon->next = NULL;
+                monitorAdd(mon);
+                kept++;
+            } else {
+                mon = monitorNew(g.x, g.y, g.width, g.height);
+                monitorAdd(mon);
+                setEwmhAtoms(mon);
+                monitorShow(mon);
+                created++;
+            }
+        }
+
+        int destroyed = 0;
+        for (monitor_t *mon : old) {
+            if (mon) {
+                monitorFree(mon);
+                destroyed++;
+            }
+        }
+        LOG_INFO("[randr] monitors: %d kept, %d created, %d destroyed", kept, created, destroyed);
+
+        assignMonitorSources();
+        if (renderBackend == RENDER_SHM && primary->width != primaryWidth &&
+            !shm.resize(primary->width, bh)) {
+            LOG_WARN("[lemonbar] shm surface unavailable, falling back to Xft");
+            shm.cleanup();
+            renderBackend = RENDER_XFT;
+        }
+
+        // El primario puede ser otro: se redibuja todo con los caches tibios
+        fullRedraw = true;
+    }
+
+    // Relee los outputs después de un evento de RandR
+    void
+    updateMonitors (void)
+    {
+        getRandrMonitors(true);
+    }
+
+    void
+    getRandrMonitors (bool hotplug = false)
     {
         xcb_randr_get_screen_resources_current_reply_t *rres_reply;
         xcb_randr_output_t *outputs;
@@ -1245,7 +2192,7 @@ public:
                                                                   xcb_randr_get_screen_resources_current(c, scr->root), NULL);
 
         if (!rres_reply) {
-            fprintf(stderr, "Failed to get current randr screen resources\n");
+            LOG_ERROR("Failed to get current randr screen resources");
             return;
         }
 
@@ -1281,7 +2228,7 @@ public:
             free(oi_reply);
 
             if (!ci_reply) {
-                fprintf(stderr, "Failed to get RandR ctrc info\n");
+                LOG_ERROR("Failed to get RandR ctrc info");
                 free(rres_reply);
                 return;
             }
@@ -1315,7 +2262,7 @@ public:
         }
 
         if (valid < 1) {
-            fprintf(stderr, "No usable RandR output found\n");
+            LOG_ERROR("No usable RandR output found");
             return;
         }
 
@@ -1325,7 +2272,10 @@ public:
             if (rects[i].width != 0)
                 r[j++] = rects[i];
 
-        monitorCreateChain(r, valid);
+        if (hotplug)
+            monitorUpdateChain(r, valid);
+        else
+            monitorCreateChain(r, valid);
     }
 
 #ifdef WITH_XINERAMA
@@ -1396,7 +2346,7 @@ public:
         while (*p) {
             // A geometry string has only 4 fields
             if (i >= 4) {
-                fprintf(stderr, "Invalid geometry specified\n");
+                LOG_ERROR("Invalid geometry specified");
                 return false;
             }
             // Move on if we encounter a 'x' or '+'
@@ -1414,14 +2364,14 @@ public:
             }
             // A digit must follow
             if (!isdigit(*p)) {
-                fprintf(stderr, "Invalid geometry specified\n");
+                LOG_ERROR("Invalid geometry specified");
                 return false;
             }
             // Try to parse the number
             errno = 0;
             j = strtoul(p, &p, 10);
             if (errno) {
-                fprintf(stderr, "Invalid geometry specified\n");
+                LOG_ERROR("Invalid geometry specified");
                 return false;
             }
             tmp[i] = j;
@@ -1433,41 +2383,46 @@ public:
     void
     xconn (void)
     {
-        fprintf(stderr, "[lemonbar] xconn: entering\n");
+        LOG_DEBUG("[lemonbar] xconn: entering");
         if ((dpy = XOpenDisplay(0)) == NULL) {
-            fprintf (stderr, "Couldnt open display\n");
+            LOG_ERROR("Couldnt open display");
         }
-        fprintf(stderr, "[lemonbar] xconn: XOpenDisplay returned %p\n", (void*)dpy);
+        LOG_DEBUG("[lemonbar] xconn: XOpenDisplay returned %p", (void*)dpy);
 
         if ((c = XGetXCBConnection(dpy)) == NULL) {
-            fprintf (stderr, "Couldnt connect to X\n");
+            LOG_ERROR("Couldnt connect to X");
             exit (EXIT_FAILURE);
         }
-        fprintf(stderr, "[lemonbar] xconn: XGetXCBConnection returned %p\n", (void*)c);
+        LOG_DEBUG("[lemonbar] xconn: XGetXCBConnection returned %p", (void*)c);
 
         XSetEventQueueOwner(dpy, XCBOwnsEventQueue);
-        fprintf(stderr, "[lemonbar] xconn: set event queue owner\n");
+        LOG_DEBUG("[lemonbar] xconn: set event queue owner");
 
         if (xcb_connection_has_error(c)) {
-            fprintf(stderr, "Couldn't connect to X\n");
+            LOG_ERROR("Couldn't connect to X");
             exit(EXIT_FAILURE);
         }
-        fprintf(stderr, "[lemonbar] xconn: xcb connection ok\n");
+        LOG_DEBUG("[lemonbar] xconn: xcb connection ok");
 
         /* Grab infos from the first screen */
         scr = xcb_setup_roots_iterator(xcb_get_setup(c)).data;
-        fprintf(stderr, "[lemonbar] xconn: got screen data\n");
+        LOG_DEBUG("[lemonbar] xconn: got screen data");
 
         /* Try to get a RGBA visual and build the colormap for that */
         visual = getVisual();
+        visualDepth = (visual == scr->root_visual) ? scr->root_depth : 32;
         colormap = xcb_generate_id(c);
         xcb_create_colormap(c, XCB_COLORMAP_ALLOC_NONE, colormap, scr->root, visual);
-        fprintf(stderr, "[lemonbar] xconn: created colormap %u visual %u\n", colormap, visual);
+        LOG_DEBUG("[lemonbar] xconn: created colormap %u visual %u", colormap, visual);
     }
 
     void
     init (char *wm_name, char *wm_instance)
     {
+        wmName = wm_name ? wm_name : "";
+        wmInstance = wm_instance ? wm_instance : "";
+        requestedBw = bw;
+
         // Try to load a default font
         if (!fontCount)
             fontLoad("fixed");
@@ -1496,6 +2451,9 @@ public:
 
         if (qe_reply && qe_reply->present) {
             getRandrMonitors();
+            // Hotplug: los cambios de outputs llegan como eventos
+            xcb_randr_select_input(c, scr->root, XCB_RANDR_NOTIFY_MASK_SCREEN_CHANGE |
+                                   XCB_RANDR_NOTIFY_MASK_OUTPUT_CHANGE | XCB_RANDR_NOTIFY_MASK_CRTC_CHANGE);
         }
 #if WITH_XINERAMA
         else {
@@ -1515,7 +2473,7 @@ public:
 #endif
 
         if (!monhead) {
-            fprintf(stderr, "[init] Creating fallback monitor: bw=%d, bh=%d, bx=%d, by=%d, screen_width=%d, screen_height=%d, maxh=%d\n",
+            LOG_DEBUG("[init] Creating fallback monitor: bw=%d, bh=%d, bx=%d, by=%d, screen_width=%d, screen_height=%d, maxh=%d",
                     bw, bh, bx, by, scr->width_in_pixels, scr->height_in_pixels, maxh);
 
             // If I fits I sits
@@ -1526,22 +2484,24 @@ public:
             if (bh < 0 || bh > scr->height_in_pixels)
                 bh = maxh + bu + 2;
 
-            fprintf(stderr, "[init] After adjustment: bw=%d, bh=%d\n", bw, bh);
+            LOG_DEBUG("[init] After adjustment: bw=%d, bh=%d", bw, bh);
 
             // Check the geometry
             if (bx + bw > scr->width_in_pixels || by + bh > scr->height_in_pixels) {
-                fprintf(stderr, "The geometry specified doesn't fit the screen!\n");
+                LOG_ERROR("The geometry specified doesn't fit the screen!");
                 exit(EXIT_FAILURE);
             }
 
             // If no RandR outputs or Xinerama screens, fall back to using whole screen
             monhead = monitorNew(0, 0, bw, scr->height_in_pixels);
-            fprintf(stderr, "[init] Created monitor: monhead=%p\n", (void*)monhead);
+            LOG_DEBUG("[init] Created monitor: monhead=%p", (void*)monhead);
         }
 
         if (!monhead)
             exit(EXIT_FAILURE);
 
+        assignMonitorSources();
+
         // For WM that support EWMH atoms
         setEwmhAtoms();
 
@@ -1556,44 +2516,24 @@ public:
         xcb_create_gc(c, gc[GC_ATTR], monhead->pixmap, XCB_GC_FOREGROUND, (const uint32_t []){ underlineColor.v });
 
         // Make the bar visible and clear the pixmap
-        for (monitor_t *mon = monhead; mon; mon = mon->next) {
-            fillRect(mon->pixmap, gc[GC_CLEAR], 0, 0, mon->width, bh);
-            xcb_map_window(c, mon->window);
-
-            // Make sure that the window really gets in the place it's supposed to be
-            // Some WM such as Openbox need this
-            xcb_configure_window(c, mon->window, XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y, (const uint32_t []){ (uint32_t)mon->x, (uint32_t)mon->y });
-
-            // Set the WM_NAME atom to the user specified value
-            if (wm_name)
-                xcb_change_property(c, XCB_PROP_MODE_REPLACE, mon->window, XCB_ATOM_WM_NAME, XCB_ATOM_STRING, 8 ,strlen(wm_name), wm_name);
-
-            // set the WM_CLASS atom instance to the executable name
-            if (wm_instance) {
-                char *wm_class;
-                int wm_class_offset, wm_class_len;
-
-                // WM_CLASS is nullbyte seperated: wm_instance + "\0Bar\0"
-                wm_class_offset = strlen(wm_instance) + 1;
-                wm_class_len = wm_class_offset + 4;
-
-                wm_class = static_cast<char *>(calloc(1, wm_class_len + 1));
-                strcpy(wm_class, wm_instance);
-                strcpy(wm_class+wm_class_offset, "Bar");
-
-                xcb_change_property(c, XCB_PROP_MODE_REPLACE, mon->window, XCB_ATOM_WM_CLASS, XCB_ATOM_STRING, 8, wm_class_len, wm_class);
-
-                free(wm_class);
-            }
-        }
+        for (monitor_t *mon = monhead; mon; mon = mon->next)
+            monitorShow(mon);
 
         char color[] = "#ffffff";
         uint32_t nfgc = foregroundColor.v & 0x00ffffff;
         snprintf(color, sizeof(color), "#%06X", nfgc);
 
         if (!XftColorAllocName (dpy, visualPtr, colormap, color, &selFg)) {
-            fprintf(stderr, "Couldn't allocate xft font color '%s'\n", color);
+            LOG_ERROR("Couldn't allocate xft font color '%s'", color);
         }
+
+        if (renderBackend == RENDER_SHM && !shm.resize(primary->width, bh)) {
+            LOG_WARN("[lemonbar] shm surface unavailable, falling back to Xft");
+            shm.cleanup();
+            renderBackend = RENDER_XFT;
+        }
+
+        prewarmGlyphCaches();
         xcb_flush(c);
     }
 
@@ -1620,25 +2560,18 @@ public:
     }
 
     ~Bar() {
-        for (int i = 0; fontList[i]; i++) {
-            if (fontList[i]->xft_ft) {
-                XftFontClose (dpy, fontList[i]->xft_ft);
-            }
-            else {
-                xcb_close_font(c, fontList[i]->ptr);
-                free(fontList[i]->width_lut);
-            }
-            free(fontList[i]);
-        }
-
         while (monhead) {
             monitor_t *next = monhead->next;
-            xcb_destroy_window(c, monhead->window);
-            xcb_free_pixmap(c, monhead->pixmap);
-            free(monhead);
+            monitorFree(monhead);
             monhead = next;
         }
 
+        LOG_INFO("[lemonbar] render cache: %llu hits, %llu misses, %llu evictions, %zu bytes",
+                (unsigned long long)renderCacheHits, (unsigned long long)renderCacheMisses,
+                (unsigned long long)renderCacheEvictions, renderCacheBytes);
+        renderCacheClear();
+        shm.cleanup();
+
         XftColorFree(dpy, visualPtr, colormap, &selFg);
 
         if (gc[GC_DRAW])
@@ -1647,8 +2580,34 @@ public:
             xcb_free_gc(c, gc[GC_CLEAR]);
         if (gc[GC_ATTR])
             xcb_free_gc(c, gc[GC_ATTR]);
+
+        // Fuentes y conexión se liberan con la última barra
+        if (--display->users > 0)
+            return;
+
+        for (int i = 0; i < fontCount; i++) {
+            if (fontList[i]->glyphs) {
+                LOG_INFO("[lemonbar] glyph cache font %d: %llu hits, %llu misses, %zu entries", i,
+                        (unsigned long long)fontList[i]->glyphs->hits,
+                        (unsigned long long)fontList[i]->glyphs->misses,
+                        fontList[i]->glyphs->others.size());
+                delete fontList[i]->glyphs;
+            }
+            if (fontList[i]->xft_ft) {
+                XftFontClose (dpy, fontList[i]->xft_ft);
+            }
+            else {
+                xcb_close_font(c, fontList[i]->ptr);
+                free(fontList[i]->width_lut);
+            }
+            free(fontList[i]);
+        }
+
+        xrender.cleanup();
+        display->shmGlyphs.clear();
         if (c)
             xcb_disconnect(c);
+        delete display;
     }
 };
 #endif /* LEMONBAR_LIB */
@@ -8,14 +8,105 @@
 #include <cstring>
 #include <map>
 #include <string>
+#include <utility>
+#include <vector>
 #include <xcb/xproto.h>
 
 // Constantes para alineación (compatibles con bar.h)
 
 #define CONTENT_MAX_LEN 255
 
+// Largo (a lo sumo len) en el que s termina en un límite de carácter UTF-8.
+// Sirve después de copiar cortando por bytes: una secuencia que quedó a
+// medias al final se descarta entera en vez de dejar un byte inicial suelto.
+inline int utf8Truncate(const char* s, int len) {
+  int start = len;
+  while (start > 0 && ((uint8_t)s[start - 1] & 0xc0) == 0x80) start--;
+  if (start == 0) return len;   // solo bytes de continuación: no hay qué cuidar
+  uint8_t lead = s[start - 1];
+  int need = (lead & 0xe0) == 0xc0 ? 2 : (lead & 0xf0) == 0xe0 ? 3 : (lead & 0xf8) == 0xf0 ? 4 : 1;
+  return (start - 1) + need > len ? start - 1 : len;
+}
+
 typedef std::function<void()> EventFunction;
 
+// Lugar del texto decodificado de un elemento en el TextArena de su barra.
+// Una copia del elemento (p.ej. la que publica un módulo bloqueante) arranca
+// sin lugar: dos elementos nunca comparten texto y la copia se vuelve a
+// parsear.
+struct TextSlot {
+  uint32_t offset;
+  uint16_t capacity;      // 0: sin lugar
+
+  TextSlot() : offset(0), capacity(0) {}
+  TextSlot(const TextSlot&) : offset(0), capacity(0) {}
+  TextSlot& operator=(const TextSlot&) { return *this; }
+};
+
+// Texto decodificado de los elementos de una barra: código, ancho y fuente
+// por carácter en tres arrays contiguos. Cada elemento tiene un tramo del
+// largo real de su contenido (redondeado a 16) en vez de tres arrays de
+// CONTENT_MAX_LEN. Un tramo que queda chico se abandona; la barra los
+// recupera copiando los vivos a un arena nuevo (Bar::compactText).
+class TextArena {
+  public:
+    TextArena() : used(0), wasted(0) {}
+
+    uint32_t* ucs(const TextSlot& slot) { return &ucsData[slot.offset]; }
+    uint8_t* widths(const TextSlot& slot) { return &widthData[slot.offset]; }
+    uint8_t* fonts(const TextSlot& slot) { return &fontData[slot.offset]; }
+
+    // Garantiza lugar para len caracteres. Puede mover el tramo: los
+    // punteros obtenidos antes dejan de valer.
+    void reserve(TextSlot& slot, int len) {
+      if (slot.capacity && slot.capacity >= len) return;
+
+      uint16_t capacity = (uint16_t)((len + 15) & ~15);
+      if (!capacity) capacity = 16;
+      wasted += slot.capacity;
+      slot.offset = used;
+      slot.capacity = capacity;
+      used += capacity;
+      if (ucsData.size() < used) {
+        size_t size = ucsData.size() ? ucsData.size() * 2 : 1024;
+        while (size < used) size *= 2;
+        ucsData.resize(size);
+        widthData.resize(size);
+        fontData.resize(size);
+      }
+    }
+
+    bool needsCompaction() const {
+      return wasted > 1024 && wasted > used / 2;
+    }
+
+    // Mueve a other el texto de slot (len caracteres) y deja slot apuntando
+    // al tramo nuevo. Para compactar: se copian los vivos a un arena vacío.
+    void moveTo(TextArena& other, TextSlot& slot, int len) {
+      uint32_t offset = slot.offset;
+      slot.capacity = 0;
+      other.reserve(slot, len);
+      memcpy(other.ucs(slot), &ucsData[offset], len * sizeof(uint32_t));
+      memcpy(other.widths(slot), &widthData[offset], len);
+      memcpy(other.fonts(slot), &fontData[offset], len);
+    }
+
+    void swap(TextArena& other) {
+      ucsData.swap(other.ucsData);
+      widthData.swap(other.widthData);
+      fontData.swap(other.fontData);
+      std::swap(used, other.used);
+      std::swap(wasted, other.wasted);
+    }
+
+  private:
+    std::vector<uint32_t> ucsData;
+    std::vector<uint8_t> widthData;
+    std::vector<uint8_t> fontData;
+    size_t used;          // caracteres asignados, vivos o abandonados
+    size_t wasted;        // de esos, los abandonados
+};
+
 struct BarElement {
 
   enum EventType {
@@ -27,19 +118,29 @@ struct BarElement {
   };
 
 
-  // --- Datos de texto (owned) ---
-  //private:
-  char content[CONTENT_MAX_LEN];
-  uint32_t ucsContent[CONTENT_MAX_LEN];
-  uint8_t  ucsContentCharWidths[CONTENT_MAX_LEN];
-  bool dirtyContent;
-  int contentLen;
-  int ucsContentLen;
+  // Los campos van ordenados por temperatura: lo que layout, damage y
+  // render tocan en cada frame queda junto al principio; handlers, nombre y
+  // el texto crudo que escribe el módulo quedan al final.
 
-  // --- Datos de posición (calculados) ---
+  // --- Hot: posición (calculada por la barra) ---
   uint16_t beginX;
   uint16_t width;
+  uint16_t fullWidth;     // ancho sin recortar
+
+  // --- Hot: damage tracking, lo que quedó dibujado en el último frame ---
+  uint16_t drawnX;
+  uint16_t drawnWidth;
+  uint32_t drawnHash;
 
+  // --- Hot: recorte. El módulo pide truncate y la barra ajusta el elemento
+  // al espacio libre entre los módulos izquierdos y los derechos ---
+  int fitWidth;           // espacio con el que se calculó visibleLen, -1 si no se calculó
+  int visibleLen;         // caracteres del texto decodificado que se dibujan
+
+  // --- Hot: texto decodificado. Vive en el TextArena de la barra ---
+  TextSlot text;
+  int ucsContentLen;
+  int contentLen;
 
   // --- Datos de color ---
   // TODO: esto debe estar acá, pero se debe poder forzar en modula
@@ -47,31 +148,106 @@ struct BarElement {
   Color backgroundColor;
   Color underlineColor;
 
-  // --- Manejo de eventos múltiples ---
-  std::map<EventType, EventFunction> events;
-  std::string moduleName;
-
   // --- Datos de formato ---
   int offsetPixels;
 
   // --- Estados y atributos ---
+  bool dirtyContent;
+  bool truncate;
+  bool drawn;
   bool underline;
   bool overline;
   bool reverseColors;     // para comando %R
   bool isActive;          // para áreas clickeables abiertas/cerradas
+  bool eventCharged;
+
+  // --- Cold: manejo de eventos múltiples ---
+  std::map<EventType, EventFunction> events;
+  std::string moduleName;
+
+  // --- Cold: texto crudo (owned), lo escribe el módulo ---
+  char content[CONTENT_MAX_LEN];
 
   // --- Métodos eficientes para manejo de eventos ---
   inline void setEvent(EventType type, std::function<void()> handler) {
     events[type] = handler;
   }
-  bool eventCharged;
+
+  // Copia lo que escribe un módulo (texto y estilo) sin tocar el estado de
+  // parseo ni de dibujo, que es de la barra
+  void copyContentFrom(const BarElement& other) {
+    if (contentLen != other.contentLen ||
+        strncmp(content, other.content, CONTENT_MAX_LEN) != 0) {
+      memcpy(content, other.content, CONTENT_MAX_LEN);
+      contentLen = other.contentLen;
+      dirtyContent = true;
+    }
+    foregroundColor = other.foregroundColor;
+    backgroundColor = other.backgroundColor;
+    underlineColor = other.underlineColor;
+    offsetPixels = other.offsetPixels;
+    underline = other.underline;
+    overline = other.overline;
+    reverseColors = other.reverseColors;
+  }
+
+  // Hash FNV-1a del contenido y del estilo. Dos frames con el mismo hash y
+  // la misma posición producen exactamente los mismos píxeles. El texto
+  // decodificado sale de content, así que alcanza con los bytes hasta donde
+  // corta el parseo.
+  uint32_t renderHash() const {
+    uint32_t h = 2166136261u;
+    const char* end = content + renderedLen();
+    for (const char* p = content; p < end; ++p)
+      h = (h ^ (uint8_t)*p) * 16777619u;
+    h = (h ^ (uint32_t)visibleLen) * 16777619u;
+    return hashStyle(h);
+  }
+
+  // Igual que renderHash() pero sobre el texto crudo, antes de parsearlo.
+  // Le sirve a un módulo para saber si un update cambió algo visible.
+  uint32_t contentHash() const {
+    uint32_t h = 2166136261u;
+    for (const char* p = content; p < content + CONTENT_MAX_LEN && *p; ++p)
+      h = (h ^ (uint8_t)*p) * 16777619u;
+    return hashStyle(h);
+  }
+
+  // Bytes de content que llegan al parseo (hasta el primer '\n')
+  int renderedLen() const {
+    const char* p = content;
+    while (p < content + CONTENT_MAX_LEN - 1 && *p && *p != '\n') ++p;
+    return p - content;
+  }
+
+  static const int STYLE_WORDS = 5;
+
+  // El estilo que entra en los hashes, en palabras comparables
+  void styleWords(uint32_t style[STYLE_WORDS]) const {
+    style[0] = foregroundColor.v;
+    style[1] = backgroundColor.v;
+    style[2] = underlineColor.v;
+    style[3] = (uint32_t)offsetPixels;
+    style[4] = (uint32_t)underline | (uint32_t)overline << 1 | (uint32_t)reverseColors << 2;
+  }
+
+  uint32_t hashStyle(uint32_t h) const {
+    uint32_t style[STYLE_WORDS];
+    styleWords(style);
+    const uint8_t* p = (const uint8_t*)style;
+    const uint8_t* end = p + sizeof(style);
+    for (; p < end; ++p) h = (h ^ *p) * 16777619u;
+    return h;
+  }
 
 
   // Constructor por defecto con valores inicializados
-  BarElement() : content(""), dirtyContent(false), contentLen(0), ucsContentLen(0),
-    beginX(0), width(0),
-    offsetPixels(0), underline(false), overline(false),
-    reverseColors(false), isActive(false), eventCharged(false) {}
+  BarElement() : beginX(0), width(0), fullWidth(0),
+    drawnX(0), drawnWidth(0), drawnHash(0),
+    fitWidth(-1), visibleLen(0), ucsContentLen(0), contentLen(0),
+    offsetPixels(0), dirtyContent(false), truncate(false), drawn(false),
+    underline(false), overline(false), reverseColors(false), isActive(false),
+    eventCharged(false), content("") {}
 
 };
 
@@ -0,0 +1,277 @@
+// Benchmark de los módulos que sondean /proc y /sys: corre update() en loop
+// contra un árbol de fixtures generado (por defecto /proc/net/dev con 200
+// interfaces y un hwmon con 64 sensores) en vez del sistema real.
+//
+//   make bench && build/module_bench --iterations=1000000
+//
+// Por módulo reporta ns/update y syscalls/update. Las syscalls se cuentan en
+// un hijo trazado con ptrace, así que el tiempo medido no las paga.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <time.h>
+#include <ftw.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/ptrace.h>
+#include <sys/wait.h>
+#include <string>
+#include <vector>
+
+#include "../modules/resources.h"
+#include "../modules/ping.h"
+#include "../modules/battery.h"
+#include "../modules/space.h"
+
+// --- Opciones ---
+struct BenchOptions {
+  long iterations = 1000000;    // updates medidos por módulo
+  long warmup = 1000;
+  long syscallIterations = 1000; // updates trazados para contar syscalls
+  int interfaces = 200;          // interfaces en /proc/net/dev, sin contar lo
+  int sensors = 64;              // temp*_input repartidos en hwmon0..N
+  int sensorsPerChip = 8;
+  const char* only = nullptr;    // correr solo este módulo
+  bool keep = false;             // no borrar los fixtures al terminar
+};
+
+static int64_t monotonicNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// --- Fixtures ---
+static bool makeDirs(const std::string& path) {
+  for (size_t i = 1; i <= path.size(); i++) {
+    if (i < path.size() && path[i] != '/') continue;
+    std::string dir = path.substr(0, i);
+    if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+      fprintf(stderr, "[bench] mkdir %s: %s\n", dir.c_str(), strerror(errno));
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool writeFile(const std::string& path, const std::string& content) {
+  FILE* f = fopen(path.c_str(), "w");
+  if (!f) {
+    fprintf(stderr, "[bench] %s: %s\n", path.c_str(), strerror(errno));
+    return false;
+  }
+  fwrite(content.data(), 1, content.size(), f);
+  fclose(f);
+  return true;
+}
+
+static bool buildProc(const std::string& proc, const BenchOptions& options) {
+  if (!makeDirs(proc + "/net")) return false;
+
+  if (!writeFile(proc + "/meminfo",
+      "MemTotal:       32768000 kB\n"
+      "MemFree:         8192000 kB\n"
+      "MemAvailable:   16384000 kB\n"
+      "Buffers:          512000 kB\n"
+      "Cached:          6144000 kB\n"))
+    return false;
+
+  std::string stat = "cpu  4705 150 1120 16250 520 0 45 0 0 0\n";
+  for (int i = 0; i < 8; i++)
+    stat += "cpu" + std::to_string(i) + " 588 18 140 2031 65 0 5 0 0 0\n";
+  stat += "intr 114930548 113199788 3 0 5 263 0 4 [...]\nctxt 1990473\n";
+  if (!writeFile(proc + "/stat", stat)) return false;
+
+  // Mismo formato que el kernel: nombre alineado a 6 y 16 columnas
+  std::string dev =
+    "Inter-|   Receive                                                |  Transmit\n"
+    " face |bytes    packets errs drop fifo frame compressed multicast|bytes    packets errs drop fifo colls carrier compressed\n"
+    "    lo: 2776770   11307    0    0    0     0          0         0  2776770   11307    0    0    0     0       0          0\n";
+  char line[256];
+  for (int i = 0; i < options.interfaces; i++) {
+    char name[16];
+    snprintf(name, sizeof(name), "veth%d", i);
+    snprintf(line, sizeof(line),
+             "%6s: %llu %7d    0    0    0     0          0         0 %llu %7d    0    0    0     0       0          0\n",
+             name, 1000000ULL * (i + 1), 1000 + i, 500000ULL * (i + 1), 800 + i);
+    dev += line;
+  }
+  return writeFile(proc + "/net/dev", dev);
+}
+
+static bool buildSys(const std::string& sys, const BenchOptions& options) {
+  int chips = (options.sensors + options.sensorsPerChip - 1) / options.sensorsPerChip;
+  int left = options.sensors;
+  for (int chip = 0; chip < chips; chip++) {
+    std::string dir = sys + "/class/hwmon/hwmon" + std::to_string(chip);
+    if (!makeDirs(dir)) return false;
+    if (!writeFile(dir + "/name", "coretemp\n")) return false;
+    for (int i = 1; i <= options.sensorsPerChip && left > 0; i++, left--) {
+      std::string temp = dir + "/temp" + std::to_string(i);
+      if (!writeFile(temp + "_input", std::to_string(40000 + chip * 1000 + i * 100) + "\n") ||
+          !writeFile(temp + "_label", "Core " + std::to_string(i) + "\n") ||
+          !writeFile(temp + "_crit", "100000\n"))
+        return false;
+    }
+  }
+
+  std::string bat = sys + "/class/power_supply/BAT0";
+  if (!makeDirs(bat)) return false;
+  // 80% descargando: no dispara la notificación de batería crítica
+  return writeFile(bat + "/energy_now", "40000000\n") &&
+         writeFile(bat + "/energy_full", "50000000\n") &&
+         writeFile(bat + "/power_now", "12000000\n") &&
+         writeFile(bat + "/status", "Discharging\n");
+}
+
+static int removeEntry(const char* path, const struct stat*, int, struct FTW*) {
+  return remove(path);
+}
+
+// --- Conteo de syscalls ---
+// El hijo corre iterations updates entre dos SIGSTOP; el padre cuenta las
+// paradas de syscall entre ambos. Devuelve -1 si no se puede trazar.
+static long tracedSyscalls(Module& module, long iterations) {
+  pid_t pid = fork();
+  if (pid < 0) return -1;
+  if (pid == 0) {
+    if (ptrace(PTRACE_TRACEME, 0, NULL, NULL) != 0) _exit(1);
+    raise(SIGSTOP);
+    for (long i = 0; i < iterations; i++) module.update();
+    raise(SIGSTOP);
+    _exit(0);
+  }
+
+  int status;
+  if (waitpid(pid, &status, 0) != pid || !WIFSTOPPED(status)) {
+    waitpid(pid, NULL, 0);
+    return -1;
+  }
+  ptrace(PTRACE_SETOPTIONS, pid, NULL, (void*)(PTRACE_O_TRACESYSGOOD | PTRACE_O_EXITKILL));
+
+  long stops = 0;
+  for (;;) {
+    if (ptrace(PTRACE_SYSCALL, pid, NULL, NULL) != 0) break;
+    if (waitpid(pid, &status, 0) != pid || !WIFSTOPPED(status)) break;
+    if (WSTOPSIG(status) == (SIGTRAP | 0x80)) {
+      stops++;
+    } else if (WSTOPSIG(status) == SIGSTOP) {
+      kill(pid, SIGKILL);
+      waitpid(pid, NULL, 0);
+      return stops / 2;   // una parada al entrar y otra al salir
+    }
+  }
+  kill(pid, SIGKILL);
+  waitpid(pid, NULL, 0);
+  return -1;
+}
+
+// Lo que cuesta el propio raise() se descuenta con una corrida vacía
+static double syscallsPerUpdate(Module& module, long iterations) {
+  long base = tracedSyscalls(module, 0);
+  long total = tracedSyscalls(module, iterations);
+  if (base < 0 || total < 0 || iterations <= 0) return -1;
+  return (double)(total - base) / iterations;
+}
+
+static void runCase(const char* name, Module& module, const BenchOptions& options) {
+  if (options.only && strcmp(options.only, name) != 0) return;
+
+  // El warmup deja abiertos los fds cacheados (hwmon, net/dev) antes de medir
+  for (long i = 0; i < options.warmup; i++) module.update();
+
+  int64_t start = monotonicNs();
+  for (long i = 0; i < options.iterations; i++) module.update();
+  int64_t elapsed = monotonicNs() - start;
+
+  double syscalls = syscallsPerUpdate(module, options.syscallIterations);
+  if (syscalls < 0) {
+    printf("  %-10s %10.1f ns/update   %8s syscalls/update\n",
+           name, (double)elapsed / options.iterations, "n/a");
+  } else {
+    printf("  %-10s %10.1f ns/update   %8.2f syscalls/update\n",
+           name, (double)elapsed / options.iterations, syscalls);
+  }
+  fflush(stdout);
+}
+
+static bool parseOptions(int argc, char* argv[], BenchOptions& options) {
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    if (strncmp(arg, "--iterations=", 13) == 0) {
+      options.iterations = atol(arg + 13);
+    } else if (strncmp(arg, "--warmup=", 9) == 0) {
+      options.warmup = atol(arg + 9);
+    } else if (strncmp(arg, "--syscall-iterations=", 21) == 0) {
+      options.syscallIterations = atol(arg + 21);
+    } else if (strncmp(arg, "--interfaces=", 13) == 0) {
+      options.interfaces = atoi(arg + 13);
+    } else if (strncmp(arg, "--sensors=", 10) == 0) {
+      options.sensors = atoi(arg + 10);
+    } else if (strncmp(arg, "--module=", 9) == 0) {
+      options.only = arg + 9;
+    } else if (strcmp(arg, "--keep") == 0) {
+      options.keep = true;
+    } else {
+      printf("Uso: %s [opciones]\n", argv[0]);
+      printf("  --iterations=N          Updates medidos por módulo (defecto 1000000)\n");
+      printf("  --warmup=N              Updates previos sin medir (defecto 1000)\n");
+      printf("  --syscall-iterations=N  Updates trazados para contar syscalls (defecto 1000)\n");
+      printf("  --interfaces=N          Interfaces en /proc/net/dev (defecto 200)\n");
+      printf("  --sensors=N             Sensores hwmon (defecto 64)\n");
+      printf("  --module=M              Solo resources, network, battery o space\n");
+      printf("  --keep                  No borrar los fixtures al terminar\n");
+      return false;
+    }
+  }
+  if (options.iterations <= 0) options.iterations = 1;
+  return true;
+}
+
+int main(int argc, char* argv[]) {
+  BenchOptions options;
+  if (!parseOptions(argc, argv, options)) return 1;
+
+  char root[] = "/tmp/photonbar-bench-XXXXXX";
+  if (!mkdtemp(root)) {
+    perror("[bench] mkdtemp");
+    return 1;
+  }
+
+  SystemPaths paths;
+  paths.proc = std::string(root) + "/proc";
+  paths.sys = std::string(root) + "/sys";
+  if (!buildProc(paths.proc, options) || !buildSys(paths.sys, options)) {
+    nftw(root, removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+    return 1;
+  }
+
+  printf("module_bench: iterations=%ld interfaces=%d sensors=%d fixtures=%s\n",
+         options.iterations, options.interfaces, options.sensors, root);
+
+  {
+    ResourcesModule resources(paths);
+    runCase("resources", resources, options);
+  }
+  {
+    // Puerto cerrado en loopback: el chequeo de latencia (uno por segundo)
+    // falla al instante en vez de salir a la red
+    PingModule ping(paths, "127.0.0.1", 9);
+    runCase("network", ping, options);
+  }
+  {
+    // Sin initialize(): no abre el socket de uevents, solo sondea los archivos
+    BatteryModule battery(paths);
+    runCase("battery", battery, options);
+  }
+  {
+    SpaceModule space(root);
+    runCase("space", space, options);
+  }
+
+  if (!options.keep) nftw(root, removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+  return 0;
+}
@@ -0,0 +1,320 @@
+// Benchmark de render: levanta una Bar contra un Xvfb propio con módulos
+// sintéticos y mide lo que cuesta cada feed().
+//
+//   make bench && build/render_bench --elements=30 --icons=20 --churn=25
+//
+// Por frame reporta tiempo (p50/p99, incluye un round trip para que cuente
+// lo que hace el servidor), requests de X y allocations (operator new).
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "../bar.h"
+
+// --- Conteo de allocations ---
+static std::atomic<uint64_t> gAllocs(0);
+
+void* operator new(size_t size) {
+  gAllocs++;
+  void* p = malloc(size ? size : 1);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void* p) noexcept {
+  free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  free(p);
+}
+
+// --- Opciones ---
+struct BenchOptions {
+  int elements = 20;      // elementos en total, mitad izquierda y mitad derecha
+  int glyphs = 8;         // caracteres por elemento
+  int iconPct = 20;       // % de glifos que son iconos Nerd Font
+  int churnPct = 25;      // % de elementos que cambian en cada frame
+  int frames = 2000;
+  int warmup = 100;
+  int backend = RENDER_XFT;
+  const char* display = nullptr;  // nullptr: levantar Xvfb
+  const char* textFont = "DejaVu Sans Mono:size=16";
+  const char* iconFont = "Symbols Nerd Font:size=16";
+};
+
+// xorshift32: reproducible entre corridas y sin allocations
+static uint32_t gRng = 2463534242u;
+static uint32_t nextRandom() {
+  gRng ^= gRng << 13;
+  gRng ^= gRng >> 17;
+  gRng ^= gRng << 5;
+  return gRng;
+}
+
+static int encodeUtf8(uint32_t ucs, char* out) {
+  if (ucs < 0x80) {
+    out[0] = ucs;
+    return 1;
+  } else if (ucs < 0x800) {
+    out[0] = 0xc0 | (ucs >> 6);
+    out[1] = 0x80 | (ucs & 0x3f);
+    return 2;
+  } else if (ucs < 0x10000) {
+    out[0] = 0xe0 | (ucs >> 12);
+    out[1] = 0x80 | ((ucs >> 6) & 0x3f);
+    out[2] = 0x80 | (ucs & 0x3f);
+    return 3;
+  }
+  out[0] = 0xf0 | (ucs >> 18);
+  out[1] = 0x80 | ((ucs >> 12) & 0x3f);
+  out[2] = 0x80 | ((ucs >> 6) & 0x3f);
+  out[3] = 0x80 | (ucs & 0x3f);
+  return 4;
+}
+
+// Iconos del BMP (Font Awesome) y de los planos suplementarios (Material)
+static const uint32_t ICONS[] = {
+  0xf011, 0xf028, 0xf026, 0xf0e7, 0xf1eb, 0xf240, 0xf244, 0xf017,
+  0xf0f3, 0xf2db, 0xf108, 0xf233,
+  0xf0379, 0xf057e, 0xf0581, 0xf05a9, 0xf0e7a, 0xf02cb,
+};
+
+// Módulo sintético: sus elementos cambian a pedido del loop
+class BenchModule : public Module {
+  public:
+    BenchModule(const char* name, int count, const BenchOptions& options) :
+      Module(name, true, 1),
+      options(options),
+      storage(count)
+    {
+      for (BarElement& element : storage) {
+        element.moduleName = this->name;
+        element.setEvent(BarElement::CLICK_LEFT, []() {});
+        elements.push_back(&element);
+        randomize(element);
+      }
+    }
+
+    void update() {
+    }
+
+    void churn() {
+      for (BarElement& element : storage) {
+        if ((int)(nextRandom() % 100) < options.churnPct) randomize(element);
+      }
+    }
+
+  private:
+    const BenchOptions& options;
+    std::vector<BarElement> storage;
+
+    void randomize(BarElement& element) {
+      char* p = element.content;
+      *p++ = ' ';
+      for (int i = 0; i < options.glyphs; i++) {
+        if ((int)(nextRandom() % 100) < options.iconPct) {
+          p += encodeUtf8(ICONS[nextRandom() % (sizeof(ICONS) / sizeof(ICONS[0]))], p);
+        } else {
+          *p++ = "abcdefghijklmnopqrstuvwxyz0123456789%"[nextRandom() % 37];
+        }
+      }
+      *p++ = ' ';
+      *p = '\0';
+      element.contentLen = p - element.content;
+      element.dirtyContent = true;
+    }
+};
+
+static int64_t monotonicNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// Levanta Xvfb en el primer display libre y espera a que acepte conexiones
+static pid_t startXvfb(std::string& display) {
+  for (int n = 90; n < 110; n++) {
+    char socketPath[64];
+    snprintf(socketPath, sizeof(socketPath), "/tmp/.X11-unix/X%d", n);
+    struct stat st;
+    if (stat(socketPath, &st) == 0) continue;
+
+    display = ":" + std::to_string(n);
+    pid_t pid = fork();
+    if (pid < 0) {
+      perror("[bench] fork");
+      return -1;
+    }
+    if (pid == 0) {
+      execlp("Xvfb", "Xvfb", display.c_str(), "-screen", "0", "1920x1080x24",
+             "-nolisten", "tcp", (char*)NULL);
+      perror("[bench] Xvfb");
+      _exit(127);
+    }
+
+    for (int i = 0; i < 100; i++) {
+      if (stat(socketPath, &st) == 0) return pid;
+      int status;
+      if (waitpid(pid, &status, WNOHANG) == pid) break;
+      usleep(50000);
+    }
+    kill(pid, SIGTERM);
+    waitpid(pid, NULL, 0);
+    fprintf(stderr, "[bench] Xvfb did not start on %s\n", display.c_str());
+    return -1;
+  }
+  fprintf(stderr, "[bench] no free display between :90 and :109\n");
+  return -1;
+}
+
+// Round trip: el frame termina cuando el servidor procesó todo. Devuelve el
+// número de secuencia del request de sync.
+static unsigned int syncX(xcb_connection_t* c) {
+  xcb_get_input_focus_cookie_t cookie = xcb_get_input_focus(c);
+  free(xcb_get_input_focus_reply(c, cookie, NULL));
+  return cookie.sequence;
+}
+
+static bool parseOptions(int argc, char* argv[], BenchOptions& options) {
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    if (strncmp(arg, "--elements=", 11) == 0) {
+      options.elements = atoi(arg + 11);
+    } else if (strncmp(arg, "--glyphs=", 9) == 0) {
+      // Cada glifo ocupa hasta 4 bytes de content (bar.h define min/max como macros)
+      options.glyphs = min(atoi(arg + 9), (CONTENT_MAX_LEN - 3) / 4);
+    } else if (strncmp(arg, "--icons=", 8) == 0) {
+      options.iconPct = atoi(arg + 8);
+    } else if (strncmp(arg, "--churn=", 8) == 0) {
+      options.churnPct = atoi(arg + 8);
+    } else if (strncmp(arg, "--frames=", 9) == 0) {
+      options.frames = atoi(arg + 9);
+    } else if (strncmp(arg, "--warmup=", 9) == 0) {
+      options.warmup = atoi(arg + 9);
+    } else if (strcmp(arg, "--render=xft") == 0) {
+      options.backend = RENDER_XFT;
+    } else if (strcmp(arg, "--render=xrender") == 0) {
+      options.backend = RENDER_XRENDER;
+    } else if (strcmp(arg, "--render=shm") == 0) {
+      options.backend = RENDER_SHM;
+    } else if (strncmp(arg, "--display=", 10) == 0) {
+      options.display = arg + 10;
+    } else if (strncmp(arg, "--font=", 7) == 0) {
+      options.textFont = arg + 7;
+    } else if (strncmp(arg, "--icon-font=", 12) == 0) {
+      options.iconFont = arg + 12;
+    } else {
+      printf("Uso: %s [opciones]\n", argv[0]);
+      printf("  --elements=N     Elementos en la barra (defecto 20)\n");
+      printf("  --glyphs=N       Caracteres por elemento (defecto 8)\n");
+      printf("  --icons=P        %% de glifos que son iconos Nerd Font (defecto 20)\n");
+      printf("  --churn=P        %% de elementos que cambian por frame (defecto 25)\n");
+      printf("  --frames=N       Frames medidos (defecto 2000)\n");
+      printf("  --warmup=N       Frames previos sin medir (defecto 100)\n");
+      printf("  --render=B       xft, xrender o shm\n");
+      printf("  --display=D      Usar un X existente en vez de levantar Xvfb\n");
+      printf("  --font=F         Fuente de texto\n");
+      printf("  --icon-font=F    Fuente de iconos\n");
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char* argv[]) {
+  BenchOptions options;
+  if (!parseOptions(argc, argv, options)) return 1;
+
+  std::string display;
+  pid_t xvfb = -1;
+  if (options.display) {
+    display = options.display;
+  } else if ((xvfb = startXvfb(display)) < 0) {
+    return 1;
+  }
+  setenv("DISPLAY", display.c_str(), 1);
+
+  int leftCount = options.elements / 2;
+  BenchModule left("left", leftCount, options);
+  BenchModule right("right", options.elements - leftCount, options);
+
+  Bar* bar = new Bar(
+    "benchBar",
+    "#1A0B2E",
+    "#E0AAFF",
+    true,
+    {std::string(options.textFont), std::string(options.iconFont)},
+    {&left},
+    {&right},
+    options.backend
+  );
+
+  std::vector<int64_t> frameNs;
+  frameNs.reserve(options.frames);
+  uint64_t requests = 0;
+  uint64_t allocs = 0;
+
+  unsigned int lastSequence = syncX(bar->c);
+  for (int frame = 0; frame < options.warmup + options.frames; frame++) {
+    left.churn();
+    right.churn();
+
+    uint64_t allocsBefore = gAllocs.load();
+    int64_t start = monotonicNs();
+    bar->feed();
+    unsigned int sequence = syncX(bar->c);
+    int64_t elapsed = monotonicNs() - start;
+
+    // Sin loop de eventos: los Expose del mapeo se descartan
+    xcb_generic_event_t* ev;
+    while ((ev = xcb_poll_for_event(bar->c))) free(ev);
+
+    if (frame < options.warmup) {
+      lastSequence = sequence;
+      continue;
+    }
+    frameNs.push_back(elapsed);
+    allocs += gAllocs.load() - allocsBefore;
+    // Todo lo que se mandó entre dos syncs, sin contar el sync
+    requests += (unsigned int)(sequence - lastSequence - 1);
+    lastSequence = sequence;
+  }
+
+  if (frameNs.empty()) {
+    fprintf(stderr, "[bench] no frames measured\n");
+  } else {
+    int64_t total = 0;
+    for (int64_t ns : frameNs) total += ns;
+    std::sort(frameNs.begin(), frameNs.end());
+    size_t n = frameNs.size();
+    static const char* backends[] = {"xft", "xrender", "shm"};
+
+    printf("render_bench: backend=%s elements=%d glyphs=%d icons=%d%% churn=%d%% frames=%zu\n",
+           backends[bar->renderBackend], options.elements, options.glyphs,
+           options.iconPct, options.churnPct, n);
+    printf("  frames/sec      %10.1f\n", n * 1e9 / total);
+    printf("  frame p50       %10.1f us\n", frameNs[n / 2] / 1e3);
+    printf("  frame p99       %10.1f us\n", frameNs[min(n - 1, n * 99 / 100)] / 1e3);
+    printf("  X requests      %10.2f /frame\n", (double)requests / n);
+    printf("  allocations     %10.2f /frame\n", (double)allocs / n);
+  }
+
+  delete bar;
+  if (xvfb > 0) {
+    kill(xvfb, SIGTERM);
+    waitpid(xvfb, NULL, 0);
+  }
+  return 0;
+}
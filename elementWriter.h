@@ -0,0 +1,148 @@
+#ifndef ELEMENTWRITER_H
+#define ELEMENTWRITER_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include "barElement.h"
+
+// Icono con sus formas ya calculadas: los bytes UTF-8 con su largo (sin
+// strlen en cada update) y el codepoint, para quien necesite resolver su
+// fuente sin decodificar.
+struct Icon {
+  char utf8[5];
+  uint8_t len;
+  uint32_t ucs;
+
+  explicit Icon(const char* s) : len(0), ucs(0) {
+    const uint8_t* u = (const uint8_t*)s;
+    len = u[0] < 0x80 ? 1 : (u[0] & 0xe0) == 0xc0 ? 2 : (u[0] & 0xf0) == 0xe0 ? 3 : 4;
+    for (int i = 0; i < len; i++) {
+      if (!u[i]) {
+        len = i;
+        break;
+      }
+      utf8[i] = s[i];
+    }
+    utf8[len] = '\0';
+
+    if (len == 1) ucs = u[0];
+    else if (len == 2) ucs = (u[0] & 0x1f) << 6 | (u[1] & 0x3f);
+    else if (len == 3) ucs = (u[0] & 0xf) << 12 | (u[1] & 0x3f) << 6 | (u[2] & 0x3f);
+    else if (len == 4) ucs = (u[0] & 0x7) << 18 | (u[1] & 0x3f) << 12 | (u[2] & 0x3f) << 6 | (u[3] & 0x3f);
+  }
+};
+
+// Escribe el contenido de un elemento directo en su buffer, sin snprintf ni
+// strings intermedios, y va comparando contra lo que ya había. commit() solo
+// marca dirtyContent si algún byte cambió: un update que produce el mismo
+// texto no hace que la barra lo vuelva a decodificar y medir.
+//
+//   ElementWriter(element).icon(ICON).text(" ").fixed(cpu, 1).text("%").commit();
+//
+// Lo que no entra en CONTENT_MAX_LEN se descarta, sin cortar un carácter
+// UTF-8 a medias: el texto termina en el último carácter completo.
+class ElementWriter {
+  public:
+    explicit ElementWriter(BarElement& element) : element(element), len(0), changed(false), full(false) {}
+
+    ElementWriter& text(const char* s) {
+      return text(s, strlen(s));
+    }
+
+    // Copia de a un carácter UTF-8: uno que no entra entero corta el texto
+    ElementWriter& text(const char* s, int n) {
+      for (int i = 0; i < n && !full; ) {
+        uint8_t lead = s[i];
+        int need = (lead & 0xe0) == 0xc0 ? 2 : (lead & 0xf0) == 0xe0 ? 3 : (lead & 0xf8) == 0xf0 ? 4 : 1;
+        if (need > n - i) need = n - i;
+        sequence(s + i, need);
+        i += need;
+      }
+      return *this;
+    }
+
+    ElementWriter& ch(char c) {
+      put(c);
+      return *this;
+    }
+
+    ElementWriter& icon(const Icon& icon) {
+      sequence(icon.utf8, icon.len);
+      return *this;
+    }
+
+    // Entero en decimal, con ceros a la izquierda hasta minDigits
+    ElementWriter& integer(long long value, int minDigits = 1) {
+      char digits[24];
+      int n = 0;
+      unsigned long long v = value < 0 ? 0ULL - (unsigned long long)value : value;
+      do {
+        digits[n++] = '0' + v % 10;
+        v /= 10;
+      } while (v && n < (int)sizeof(digits));
+      while (n < minDigits && n < (int)sizeof(digits)) digits[n++] = '0';
+      if (value < 0) put('-');
+      while (n) put(digits[--n]);
+      return *this;
+    }
+
+    // Punto fijo con decimals decimales (hasta 6). Como %.Nf salvo en los
+    // empates exactos, que redondea lejos del cero, y en que nunca escribe -0
+    ElementWriter& fixed(double value, int decimals) {
+      if (std::isnan(value) || std::isinf(value)) return ch('?');
+      if (decimals > 6) decimals = 6;
+
+      static const long long scales[] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+      long long scale = scales[decimals < 0 ? 0 : decimals];
+      long long scaled = llround(value * scale);
+      if (scaled < 0) {
+        put('-');
+        scaled = -scaled;
+      }
+      integer(scaled / scale);
+      if (decimals > 0) {
+        put('.');
+        integer(scaled % scale, decimals);
+      }
+      return *this;
+    }
+
+    // Cierra el texto. true si cambió algo respecto del frame anterior.
+    bool commit() {
+      if (len != element.contentLen) changed = true;
+      element.content[len] = '\0';
+      element.contentLen = len;
+      if (changed) element.dirtyContent = true;
+      return changed;
+    }
+
+  private:
+    BarElement& element;
+    int len;
+    bool changed;
+    bool full;      // algo ya no entró: no se escribe nada más
+
+    inline void put(char c) {
+      if (full || len >= CONTENT_MAX_LEN - 1) {
+        full = true;
+        return;
+      }
+      if (element.content[len] != c) {
+        element.content[len] = c;
+        changed = true;
+      }
+      len++;
+    }
+
+    // Una secuencia se escribe entera o no se escribe
+    inline void sequence(const char* s, int n) {
+      if (full || len + n > CONTENT_MAX_LEN - 1) {
+        full = true;
+        return;
+      }
+      for (int i = 0; i < n; i++) put(s[i]);
+    }
+};
+
+#endif // ELEMENTWRITER_H
@@ -26,6 +26,18 @@ namespace Helper {
   static constexpr const char* ICON_BATTERY_90           = u8"\U000f0082";
   static constexpr const char* ICON_BATTERY_100          = u8"\U000f0079";
 
+  // Rangos de codepoints usados por los iconos de arriba, para pre-calentar
+  // los caches de glifos de la barra
+  struct CodepointRange {
+    uint32_t first;
+    uint32_t last;
+  };
+
+  static constexpr CodepointRange ICON_RANGES[] = {
+    {0xf0079, 0xf008e},  // batería cargando / descargando
+    {0xf089c, 0xf089f},  // batería cargando (10/50/70/0)
+  };
+
   inline const char* getBatteryIcon(const uint8_t percentage, const bool charging = false) {
     if (charging) {
       if (percentage >= 95) return ICON_BATTERY_CHARGING_100;
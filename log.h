@@ -0,0 +1,277 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <atomic>
+#ifdef LOG_ASYNC
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+// Log con niveles resueltos al compilar. Lo que queda por debajo de
+// LOG_LEVEL se va entero: la macro no evalúa sus argumentos ni deja una
+// llamada. Por defecto INFO (make); make debug compila con DEBUG y LOG_ASYNC.
+//
+//   LOG_TRACE  cada frame / cada evento de X
+//   LOG_DEBUG  cosas que pasan pocas veces por segundo
+//   LOG_INFO   arranque, cambios de configuración, resúmenes al salir
+//   LOG_WARN   algo falló pero hay plan B
+//   LOG_ERROR  algo falló y no lo hay
+//
+// Cada línea sale en un solo write() al destino (stderr o --log-file). Con
+// LOG_ASYNC las líneas van a un ring sin locks y un hilo las escribe: quien
+// loguea nunca espera al disco. Si el ring se llena, la línea se descarta y
+// se cuenta.
+
+#define LOG_LEVEL_TRACE 0
+#define LOG_LEVEL_DEBUG 1
+#define LOG_LEVEL_INFO  2
+#define LOG_LEVEL_WARN  3
+#define LOG_LEVEL_ERROR 4
+#define LOG_LEVEL_OFF   5
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#define LOG_LINE_MAX 256
+
+class Log {
+public:
+    static Log& instance() {
+        static Log log;
+        return log;
+    }
+
+    // Agrega las líneas a path en vez de mandarlas a stderr
+    bool setFile(const char* path) {
+        int fd = open(path, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+        if (fd == -1) {
+            fprintf(stderr, "[log] %s: %s\n", path, strerror(errno));
+            return false;
+        }
+        int old = sinkFd.exchange(fd);
+        if (old != STDERR_FILENO) close(old);
+        return true;
+    }
+
+    __attribute__((format(printf, 3, 4)))
+    void write(int level, const char* format, ...) {
+        char line[LOG_LINE_MAX];
+        int len = prefix(line, level);
+
+        va_list args;
+        va_start(args, format);
+        int n = vsnprintf(line + len, sizeof(line) - len - 1, format, args);
+        va_end(args);
+        if (n < 0) return;
+        len += n;
+        if (len > (int)sizeof(line) - 2) len = sizeof(line) - 2;
+        if (line[len - 1] != '\n') line[len++] = '\n';
+
+#ifdef LOG_ASYNC
+        ring.push(line, len);
+        if (ring.pending() > LOG_RING_SLOTS / 2) wake.notify_one();
+#else
+        writeAll(line, len);
+#endif
+    }
+
+private:
+    std::atomic<int> sinkFd;
+
+    Log() : sinkFd(STDERR_FILENO) {
+#ifdef LOG_ASYNC
+        // El hilo nace con todas las señales bloqueadas: las que el proceso
+        // atiende (SIGUSR1 por signalfd, SIGTERM) no le pueden caer a él
+        sigset_t all, old;
+        sigfillset(&all);
+        pthread_sigmask(SIG_BLOCK, &all, &old);
+        drainer = std::thread([this]() { drainLoop(); });
+        pthread_sigmask(SIG_SETMASK, &old, NULL);
+#endif
+    }
+
+    ~Log() {
+#ifdef LOG_ASYNC
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        drainer.join();
+#endif
+        int fd = sinkFd.load();
+        if (fd != STDERR_FILENO) close(fd);
+    }
+
+    static int prefix(char* line, int level) {
+        static const char* const tags[] = {"TRACE", "DEBUG", "INFO", "WARN", "ERROR"};
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        struct tm tm;
+        localtime_r(&ts.tv_sec, &tm);
+        return snprintf(line, LOG_LINE_MAX, "%02d:%02d:%02d.%03ld %-5s ",
+                        tm.tm_hour, tm.tm_min, tm.tm_sec, ts.tv_nsec / 1000000, tags[level]);
+    }
+
+    void writeAll(const char* data, size_t len) {
+        int fd = sinkFd.load(std::memory_order_relaxed);
+        while (len) {
+            ssize_t n = ::write(fd, data, len);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return;
+            data += n;
+            len -= n;
+        }
+    }
+
+#ifdef LOG_ASYNC
+    static const size_t LOG_RING_SLOTS = 1024;
+
+    // Cola acotada de varios productores (render y workers) y un consumidor.
+    // Cada slot tiene su número de secuencia: un productor reserva una
+    // posición con CAS, copia la línea y recién entonces la publica.
+    class Ring {
+    public:
+        Ring() : head(0), tail(0), dropped(0) {
+            for (size_t i = 0; i < LOG_RING_SLOTS; i++)
+                slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        void push(const char* text, int len) {
+            size_t pos = head.load(std::memory_order_relaxed);
+            for (;;) {
+                Slot& slot = slots[pos % LOG_RING_SLOTS];
+                size_t sequence = slot.sequence.load(std::memory_order_acquire);
+                intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+                if (diff == 0) {
+                    if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                } else if (diff < 0) {
+                    dropped.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                } else {
+                    pos = head.load(std::memory_order_relaxed);
+                }
+            }
+            Slot& slot = slots[pos % LOG_RING_SLOTS];
+            memcpy(slot.text, text, len);
+            slot.len = len;
+            slot.sequence.store(pos + 1, std::memory_order_release);
+        }
+
+        // Solo el hilo del log. Copia a out las líneas publicadas que entren.
+        size_t pop(char* out, size_t capacity) {
+            size_t used = 0;
+            size_t pos = tail.load(std::memory_order_relaxed);
+            for (;;) {
+                Slot& slot = slots[pos % LOG_RING_SLOTS];
+                if (slot.sequence.load(std::memory_order_acquire) != pos + 1)
+                    break;
+                if (used + slot.len > capacity)
+                    break;
+                memcpy(out + used, slot.text, slot.len);
+                used += slot.len;
+                slot.sequence.store(pos + LOG_RING_SLOTS, std::memory_order_release);
+                pos++;
+            }
+            tail.store(pos, std::memory_order_relaxed);
+            return used;
+        }
+
+        size_t pending() const {
+            return head.load(std::memory_order_relaxed) - tail.load(std::memory_order_relaxed);
+        }
+
+        uint64_t takeDropped() {
+            return dropped.exchange(0, std::memory_order_relaxed);
+        }
+
+    private:
+        struct Slot {
+            std::atomic<size_t> sequence;
+            uint16_t len;
+            char text[LOG_LINE_MAX];
+        };
+        Slot slots[LOG_RING_SLOTS];
+        std::atomic<size_t> head;
+        std::atomic<size_t> tail;      // solo lo avanza el consumidor
+        std::atomic<uint64_t> dropped;
+    };
+
+    Ring ring;
+    std::thread drainer;
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    // Escribe en tandas: un write() por cada 16K de líneas
+    void drainLoop() {
+        static char batch[16384];
+        for (;;) {
+            bool stop;
+            {
+                std::unique_lock<std::mutex> lock(wakeMutex);
+                wake.wait_for(lock, std::chrono::milliseconds(50));
+                stop = stopping;
+            }
+
+            size_t n;
+            while ((n = ring.pop(batch, sizeof(batch))) > 0)
+                writeAll(batch, n);
+
+            uint64_t dropped = ring.takeDropped();
+            if (dropped) {
+                char line[64];
+                int len = snprintf(line, sizeof(line), "[log] %llu lines dropped\n",
+                                   (unsigned long long)dropped);
+                writeAll(line, len);
+            }
+            if (stop) return;
+        }
+    }
+#endif
+};
+
+#if LOG_LEVEL <= LOG_LEVEL_TRACE
+#define LOG_TRACE(...) Log::instance().write(LOG_LEVEL_TRACE, __VA_ARGS__)
+#else
+#define LOG_TRACE(...) do {} while (0)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) Log::instance().write(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) do {} while (0)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(...) Log::instance().write(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) do {} while (0)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_WARN
+#define LOG_WARN(...) Log::instance().write(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...) do {} while (0)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) Log::instance().write(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) do {} while (0)
+#endif
+
+#endif
@@ -6,7 +6,9 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
-#include <sys/select.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
 #include <time.h>
 #include <xcb/xcb.h>
 #include <sys/wait.h>
@@ -22,14 +24,16 @@
 #include <thread>
 #include <atomic>
 #include <mutex>
-#include <condition_variable>
 #include <chrono>
+#include <queue>
+#include <errno.h>
 
 // --- MÓDULOS PROPIOS ---
 #include "modules/datetime.h"
 #include "modules/battery.h"
 #include "modules/audio.h"
 #include "modules/workspace.h"
+#include "modules/window.h"
 #include "modules/resources.h"
 #include "modules/ping.h"
 #include "modules/stopwatch.h"
@@ -38,6 +42,9 @@
 #include "modules/space.h"
 #include "modules/notifications.h"
 #include "process_manager.h"
+#include "worker_pool.h"
+#include "stats.h"
+#include "log.h"
 #include "bar.h"
 
 // --- CONFIGURACIÓN VISUAL ---
@@ -53,31 +60,114 @@
 
 class BarManager; // Forward declaration
 
-// Variables globales para manejo de señales y múltiples barras
+// Variables globales para manejo de señales
 static std::atomic<bool> gShutdown(false);
 
-// Referencias globales para callbacks de click (compatible con hilos)
-static BarManager* gBarManagers[2] = {nullptr, nullptr};
-static std::mutex gBarManagerMutex;
+// Backend de texto elegido con --render
+static int gRenderBackend = RENDER_XFT;
 
-// Sincronización para inicialización secuencial
-static std::mutex gInitMutex;
-static std::condition_variable gInitCv;
-static bool gTopReady = false;
+// Tope de frames por segundo por barra (--max-fps)
+static int gMaxFps = 60;
+
+// Un solo hilo atiende todas las barras. Comparten la conexión con X (y con
+// ella fuentes y caches de glifos), un epoll, un timerfd, el eventfd de
+// pedidos de render y el pool de workers. Los eventos de X se reparten por
+// id de ventana; cada BarManager conserva sus módulos, sus deadlines y su
+// tope de frames.
+class BarLoop {
+public:
+  BarLoop() : workers(2) {}
+
+  bool setup() {
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    renderFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd == -1 || timerFd == -1 || renderFd == -1) {
+      LOG_ERROR("[BarLoop] epoll/timerfd/eventfd: %s", strerror(errno));
+      return false;
+    }
+
+    watchFd(timerFd);
+    watchFd(renderFd);
+    watchFd(workers.eventFd());
+
+    // Sin stats la barra funciona igual
+    if (stats.start()) {
+      if (stats.listenSocket() != -1) watchFd(stats.listenSocket());
+      if (stats.signalSocket() != -1) watchFd(stats.signalSocket());
+    }
+    return true;
+  }
+
+  // La barra ya tiene que estar inicializada: recién ahí sus módulos
+  // conocen los fds que quieren vigilar
+  void add(BarManager* manager);
+
+  void run();
+
+  // Despierta el loop para que atienda pedidos de render. Se puede llamar
+  // desde cualquier hilo.
+  void wake() {
+    uint64_t one = 1;
+    if (write(renderFd, &one, sizeof(one)) < 0) {
+      LOG_WARN("[BarLoop] render eventfd write: %s", strerror(errno));
+    }
+  }
+
+  void submit(std::function<void()> work, std::function<bool()> done) {
+    workers.submit(work, done);
+  }
+
+  void watchFd(int fd) {
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    // MOD primero: un fd que se cerró y se reabrió con el mismo número ya
+    // no está registrado y cae en el ADD
+    if (epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &ev) == -1 && errno == ENOENT) {
+      if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+        LOG_WARN("[BarLoop] epoll_ctl: %s", strerror(errno));
+      }
+    }
+  }
+
+  // Sale del epoll solo si ningún módulo de ninguna barra lo sigue usando
+  void unwatchFd(int fd);
+
+private:
+  std::vector<BarManager*> managers;
+  std::vector<Bar*> bars;
+
+  int epollFd = -1;
+  int timerFd = -1;
+  int renderFd = -1;
+  int xcbFd = -1;
+
+  // Updates bloqueantes (red, subprocesos) fuera del hilo de render
+  WorkerPool workers;
+
+  // Socket de stats y SIGUSR1 (stats.h)
+  StatsServer stats;
+
+  void armTimer();
+};
 
 class BarManager {
 public:
   BarManager(
+    BarLoop& loop,
     const char* name,
     const bool isTop,
     const std::vector<Module*> &leftModules,
-    const std::vector<Module*> &rightModules
+    const std::vector<Module*> &rightModules,
+    BarManager* shareWith = nullptr
   ) :
     name(name),
     leftModules(leftModules),
     rightModules(rightModules),
     isTop(isTop),
-    xcb_fd(-1)
+    loop(loop),
+    frameIntervalMs(gMaxFps > 0 ? 1000 / gMaxFps : 0)
   {
     // Guardar las direcciones de los módulos pasados por parámetro
     for (Module* module : leftModules) {
@@ -88,12 +178,17 @@ public:
       modules.push_back(module);
     }
 
-    // Encontrar y guardar referencia al módulo workspace
     for (auto* module : modules) {
-      module->setRenderFunction([this]() { renderBar(); });
-      if (module->getName() == "workspace") {
-        workspace = static_cast<WorkspaceModule*>(module);
-      }
+      module->stats = Stats::instance().module(std::string(name) + "/" + module->getName());
+      module->setRenderFunction([this]() { requestRender(); });
+      // El pool es de todas las barras: el resultado marca sucia a la dueña
+      module->setAsyncFunction([this](std::function<void()> work, std::function<bool()> done) {
+        this->loop.submit(work, [this, done]() {
+          if (!done()) return false;
+          renderRequested.store(true);
+          return true;
+        });
+      });
     }
 
     bar = new Bar(
@@ -103,9 +198,10 @@ public:
       this->isTop,
       {std::string(FONT_TEXT), std::string(FONT_ICON)},
       leftModules,
-      rightModules
+      rightModules,
+      gRenderBackend,
+      shareWith ? shareWith->bar : nullptr
     );
-    xcb_fd = bar->getXcbFd();
   }
 
   bool initialize() {
@@ -113,90 +209,94 @@ public:
       return false;
     }
 
-    setvbuf(stdout, NULL, _IONBF, 0);
-
-    // Si es la barra superior, notificar que está lista
-    if (this->isTop) {
-      {
-        std::lock_guard<std::mutex> lock(gInitMutex);
-        gTopReady = true;
-      }
-      gInitCv.notify_one();
-      fprintf(stderr, "[BarManager] Barra superior inicializada y lista\n");
+    // Primera copia de los elementos de los módulos bloqueantes
+    for (Module* module : modules) {
+      if (module->isBlocking()) module->publishElements();
     }
 
+    setvbuf(stdout, NULL, _IONBF, 0);
+    LOG_INFO("[BarManager] Barra %s inicializada y lista", name.c_str());
     return true;
   }
 
-  void run() {
-    renderBar(); // Initial render
-
-    while (!gShutdown.load()) {
-      struct timeval tv;
-      fd_set fds;
-      struct timespec ts;
+  Bar* getBar() {
+    return bar;
+  }
 
-      // Set timeout for ~1 second intervals
-      clock_gettime(CLOCK_REALTIME, &ts);
-      long usec = 1000000 - (ts.tv_nsec / 1000) + 10000;
-      tv.tv_sec = 0; tv.tv_usec = usec;
+  // Primer frame y todos los módulos vencidos: el primer ciclo los actualiza
+  void start(int64_t now) {
+    for (Module* module : modules) {
+      watchModule(module);
+    }
 
-      FD_ZERO(&fds);
-      if (xcb_fd != -1) FD_SET(xcb_fd, &fds); // Escuchar eventos X
-      int i3_fd = workspace ? workspace->setupSelectFds(fds) : -1; // Escuchar cambios de escritorio
+    renderBar();
+    lastFrameMs = now;
 
-      // Calcular max_fd correctamente cuando no hay workspace
-      int max_fd = -1;
-      if (xcb_fd != -1) max_fd = xcb_fd;
-      if (i3_fd > max_fd) max_fd = i3_fd;
+    for (Module* module : modules) {
+      schedule(module, now);
+    }
+  }
 
-      int ret;
-      // Si no hay file descriptors válidos, usar timeout
-      if (max_fd == -1) {
-        tv.tv_sec = 1;  // Timeout de 1 segundo si no hay eventos
-        tv.tv_usec = 0;
-        ret = select(0, NULL, NULL, NULL, &tv);
-      } else {
-        ret = select(max_fd + 1, &fds, NULL, NULL, &tv);
+  // Reparte un fd listo entre los módulos que lo vigilan. Varios módulos
+  // pueden compartir un fd (el socket de eventos de i3).
+  void handleFd(int fd) {
+    scratchModules.clear();
+    for (auto& watched : moduleFds) {
+      if (watched.second == fd) scratchModules.push_back(watched.first);
+    }
+    for (Module* module : scratchModules) {
+      bool changed;
+      {
+        StatsTimer timer(module->stats->events);
+        changed = module->handleEvent(fd);
       }
+      if (changed) renderRequested.store(true);
+      // El módulo puede haber reabierto sus fds (p.ej. al reconectar con i3)
+      watchModule(module);
+    }
+  }
 
+  bool usesFd(int fd) const {
+    for (auto& watched : moduleFds) {
+      if (watched.second == fd) return true;
+    }
+    return false;
+  }
 
+  // Una vuelta del loop: módulos vencidos y, si toca, el frame
+  void tick(int64_t now) {
+    // Solo se tocan los módulos cuyo deadline venció
+    if (runDueModules(now)) renderRequested.store(true);
 
-      if (ret < 0) {
-        perror("select error");
-        break;
-      }
-
-      bool workspace_changed = workspace ? workspace->handleI3Events(fds) : false;
+    // Un click puede haber cambiado el intervalo de un módulo
+    for (Module* module : modules) {
+      if (module->scheduleChanged) schedule(module, now);
+    }
 
-      // Procesar eventos X - estos pueden generar clicks que se manejan por separado
-      if (xcb_fd != -1 && FD_ISSET(xcb_fd, &fds)) {
-        handleXEvents(fds);
-      }
+    flushRender(now);
+  }
 
-      // Determinar si necesitamos actualizar módulos
-      bool should_update = false;
-      if (workspace_changed) {
-        fprintf(stderr, "[BarManager] Workspace changed, marking for update\n");
-        workspace->update();
-        should_update = true;
-      } else
-      if (ret == 0) {
-        // Timeout reached - revisar módulos para actualización periódica
-        fprintf(stderr, "[BarManager] Timeout reached, checking modules\n");
-        should_update = true;
-      }
-      // Nota: Los clicks se procesan en callbacks asíncronos que llaman a render_bar directamente
+  // Próximo instante en que la barra necesita al loop (módulo o frame
+  // postergado), -1 si ninguno
+  int64_t nextWake() {
+    while (!deadlines.empty() && deadlines.top().at != deadlines.top().module->scheduledAt) {
+      deadlines.pop();
+    }
 
-      // Actualizar módulos solo si es necesario
-      if (should_update) {
-        updateModules();
+    int64_t at = deadlines.empty() ? -1 : deadlines.top().at;
+    if (frameDueAt >= 0 && (at < 0 || frameDueAt < at)) {
+      at = frameDueAt;
+    }
+    return at;
+  }
 
-        // Renderizar solo si algún módulo se actualizó
-        if (hasUpdates()) {
-          renderBar();
-        }
-      }
+  // Pide un frame. Se puede llamar desde cualquier hilo y las veces que sea:
+  // los pedidos se juntan y el loop dibuja a lo sumo un frame por intervalo.
+  void requestRender() {
+    if (!renderRequested.exchange(true)) {
+      loop.wake();
+    } else {
+      bar->getStats()->renderCoalesced.fetch_add(1, std::memory_order_relaxed);
     }
   }
 
@@ -209,83 +309,235 @@ private:
   const bool isTop;
 
   // State
-  bool any_updated = false;
-  int xcb_fd;
+  BarLoop& loop;
   Bar* bar;
-  WorkspaceModule* workspace = nullptr;
 
-  // Eliminados handlers estáticos duplicados - ahora usa lambda con captura this
-
-  // Métodos del scheduler migrados
-  void registerModule(Module* module) {
-    modules.push_back(module);
-  }
+  // Scheduler: min-heap de deadlines; el timerfd del loop se arma con el
+  // más próximo de todas las barras
+  struct Deadline {
+    int64_t at;
+    Module* module;
+    bool operator>(const Deadline& other) const { return at > other.at; }
+  };
+  std::priority_queue<Deadline, std::vector<Deadline>, std::greater<Deadline>> deadlines;
+  std::vector<std::pair<Module*, int>> moduleFds;
+  std::vector<int> scratchFds;
+  std::vector<Module*> scratchModules;
+
+  // Coalescing de renders: requestRender marca la barra sucia y flushRender
+  // dibuja cuando pasó frameIntervalMs desde el último frame
+  std::atomic<bool> renderRequested{false};
+  int64_t frameIntervalMs;
+  int64_t lastFrameMs = 0;
+  int64_t frameDueAt = -1;      // frame postergado por el tope de fps
 
   bool initializeAllModules() {
     for (auto* module : modules) {
       if (!module->initialize()) {
-        fprintf(stderr, "[BarManager] Failed to initialize %s module\n", module->getName().c_str());
+        LOG_ERROR("[BarManager] Failed to initialize %s module", module->getName().c_str());
         return false;
       }
     }
     return true;
   }
 
-  void updateModules() {
-    any_updated = false;
-    for (Module* module : modules) {
-      if (module->checkAndUpdate()) {
-        any_updated = true;
+  // Sincroniza el epoll con los fds que el módulo declara ahora
+  void watchModule(Module* module) {
+    scratchFds.clear();
+    module->eventFds(scratchFds);
+
+    for (auto it = moduleFds.begin(); it != moduleFds.end();) {
+      if (it->first == module &&
+          std::find(scratchFds.begin(), scratchFds.end(), it->second) == scratchFds.end()) {
+        int fd = it->second;
+        it = moduleFds.erase(it);
+        loop.unwatchFd(fd);
+      } else {
+        ++it;
+      }
+    }
+
+    for (int fd : scratchFds) {
+      loop.watchFd(fd);
+      if (std::find(moduleFds.begin(), moduleFds.end(), std::make_pair(module, fd)) == moduleFds.end()) {
+        moduleFds.emplace_back(module, fd);
       }
     }
   }
 
-  bool hasUpdates() const {
-    return any_updated;
+  // Reprograma el módulo. Las entradas viejas quedan en el heap y se
+  // descartan al salir porque ya no coinciden con scheduledAt.
+  void schedule(Module* module, int64_t now) {
+    module->scheduleChanged = false;
+    module->scheduledAt = module->nextDeadline(now);
+    if (module->scheduledAt >= 0) {
+      deadlines.push({module->scheduledAt, module});
+    }
   }
 
-  void renderBar() {
-    // Los módulos ya se actualizaron a través del scheduler
-    static int renderCount = 0;
+  bool runDueModules(int64_t now) {
+    bool updated = false;
+    while (!deadlines.empty() && deadlines.top().at <= now) {
+      Deadline due = deadlines.top();
+      deadlines.pop();
+      if (due.at != due.module->scheduledAt) continue;
+
+      // Los bloqueantes van al pool; si el anterior no terminó, se saltea
+      if (due.module->isBlocking()) {
+        Module* module = due.module;
+        module->lastRunMs = now;
+        if (!module->updateQueued) {
+          module->updateQueued = true;
+          module->runAsync(
+            [module]() {
+              std::lock_guard<std::mutex> lock(module->updateMutex);
+              StatsTimer timer(module->stats->updates);
+              module->update();
+            },
+            [module]() {
+              module->updateQueued = false;
+              return module->publishElements();
+            }
+          );
+        }
+        schedule(module, now);
+        continue;
+      }
 
-    renderCount++;
-    fprintf(stderr, "[BarManager] Rendering bar with content, num: %i", renderCount);
-    bar->feed();
+      // Solo cuenta como cambio si el contenido visible es otro
+      uint32_t before = due.module->elementsHash();
+      due.module->lastRunMs = now;
+      {
+        StatsTimer timer(due.module->stats->updates);
+        due.module->update();
+      }
+      schedule(due.module, now);
+      if (due.module->elementsHash() != before) updated = true;
+    }
+    return updated;
   }
 
-  void handleXEvents(fd_set &fds) {
-    // 2. EVENTOS X - just process them, don't render
-    if (xcb_fd != -1 && FD_ISSET(xcb_fd, &fds)) {
-      bar->processXEvents();
+  // Dibuja si hay pedidos pendientes y ya pasó el intervalo mínimo entre
+  // frames; si no, deja el frame programado para frameDueAt
+  void flushRender(int64_t now) {
+    if (!renderRequested.load()) return;
+
+    if (now - lastFrameMs < frameIntervalMs) {
+      if (frameDueAt < 0) bar->getStats()->framesDeferred.fetch_add(1, std::memory_order_relaxed);
+      frameDueAt = lastFrameMs + frameIntervalMs;
+      return;
     }
+
+    renderRequested.store(false);
+    frameDueAt = -1;
+    lastFrameMs = now;
+    renderBar();
+  }
+
+  void renderBar() {
+    // Los módulos ya se actualizaron a través del scheduler; los frames
+    // dibujados se cuentan en las stats
+    LOG_TRACE("[BarManager] Rendering %s", name.c_str());
+    bar->feed();
   }
 };
 
-// --- MAIN LOOP CON HILOS ---
+void BarLoop::add(BarManager* manager) {
+  managers.push_back(manager);
+  bars.push_back(manager->getBar());
+
+  // Todas las barras hablan por la misma conexión
+  if (xcbFd == -1) {
+    xcbFd = manager->getBar()->getXcbFd();
+    if (xcbFd != -1) watchFd(xcbFd);
+  }
+}
+
+void BarLoop::unwatchFd(int fd) {
+  for (BarManager* manager : managers) {
+    if (manager->usesFd(fd)) return;
+  }
+  epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, NULL);
+}
+
+// Arma el timerfd con el deadline más próximo de todas las barras; sin
+// deadlines queda desarmado y el hilo duerme hasta el próximo evento
+void BarLoop::armTimer() {
+  int64_t at = -1;
+  for (BarManager* manager : managers) {
+    int64_t wake = manager->nextWake();
+    if (wake >= 0 && (at < 0 || wake < at)) at = wake;
+  }
+
+  struct itimerspec its = {};
+  if (at >= 0) {
+    its.it_value.tv_sec = at / 1000;
+    its.it_value.tv_nsec = (at % 1000) * 1000000;
+  }
+  timerfd_settime(timerFd, TFD_TIMER_ABSTIME, &its, NULL);
+}
+
+void BarLoop::run() {
+  int64_t now = monotonicMs();
+  for (BarManager* manager : managers) {
+    manager->start(now);
+  }
+
+  while (!gShutdown.load()) {
+    armTimer();
+
+    struct epoll_event events[8];
+    int n = epoll_wait(epollFd, events, 8, -1);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      LOG_ERROR("[BarLoop] epoll_wait: %s", strerror(errno));
+      break;
+    }
+
+    for (int i = 0; i < n; i++) {
+      int fd = events[i].data.fd;
+
+      if (fd == timerFd) {
+        uint64_t expirations;
+        if (read(timerFd, &expirations, sizeof(expirations)) < 0 && errno != EAGAIN) {
+          LOG_WARN("[BarLoop] timerfd read: %s", strerror(errno));
+        }
+      } else if (fd == renderFd) {
+        // Pedidos de render de callbacks: se resuelven en el tick de cada barra
+        uint64_t requests;
+        if (read(renderFd, &requests, sizeof(requests)) < 0 && errno != EAGAIN) {
+          LOG_WARN("[BarLoop] render eventfd read: %s", strerror(errno));
+        }
+      } else if (fd == workers.eventFd()) {
+        // Resultados de updates que corrieron en el pool; cada uno marca su barra
+        workers.collect();
+      } else if (stats.owns(fd)) {
+        int client = stats.handleFd(fd);
+        if (client != -1) watchFd(client);
+      } else if (fd == xcbFd) {
+        // Los clicks se resuelven en callbacks que piden un render con requestRender
+        Bar::processXEvents(bars);
+      } else {
+        for (BarManager* manager : managers) {
+          manager->handleFd(fd);
+        }
+      }
+    }
+
+    now = monotonicMs();
+    for (BarManager* manager : managers) {
+      manager->tick(now);
+    }
+  }
+}
+
+// --- MAIN ---
 int main(int argc, char* argv[]) {
   bool restart_mode = false;
   bool no_lock = false;
   bool kill_only = false;
   bool verbose = true;
 
-  // Debug logging: Imprimir información de entorno
-  FILE* debug_log = fopen("/tmp/myBar_debug.log", "a");
-  if (debug_log) {
-    fprintf(debug_log, "=== myBar Inicio ===\n");
-    fprintf(debug_log, "Timestamp: %ld\n", time(nullptr));
-    fprintf(debug_log, "User: %s\n", getenv("USER") ? getenv("USER") : "unknown");
-    fprintf(debug_log, "Home: %s\n", getenv("HOME") ? getenv("HOME") : "unknown");
-    fprintf(debug_log, "Display: %s\n", getenv("DISPLAY") ? getenv("DISPLAY") : "unknown");
-    fprintf(debug_log, "Path: %s\n", getenv("PATH") ? getenv("PATH") : "unknown");
-    fprintf(debug_log, "PWD: %s\n", getenv("PWD") ? getenv("PWD") : "unknown");
-    fprintf(debug_log, "Args:");
-    for (int i = 0; i < argc; i++) {
-      fprintf(debug_log, " [%d]=%s", i, argv[i]);
-    }
-    fprintf(debug_log, "\n");
-    fflush(debug_log);
-  }
-
   // Parsear argumentos
   for (int i = 1; i < argc; i++) {
     if (strcmp(argv[i], "--restart") == 0) {
@@ -296,6 +548,16 @@ int main(int argc, char* argv[]) {
       kill_only = true;
     } else if (strcmp(argv[i], "--quiet") == 0) {
       verbose = false;
+    } else if (strcmp(argv[i], "--render=xft") == 0) {
+      gRenderBackend = RENDER_XFT;
+    } else if (strcmp(argv[i], "--render=xrender") == 0) {
+      gRenderBackend = RENDER_XRENDER;
+    } else if (strcmp(argv[i], "--render=shm") == 0) {
+      gRenderBackend = RENDER_SHM;
+    } else if (strncmp(argv[i], "--max-fps=", 10) == 0) {
+      gMaxFps = atoi(argv[i] + 10);
+    } else if (strncmp(argv[i], "--log-file=", 11) == 0) {
+      Log::instance().setFile(argv[i] + 11);
     } else if (strcmp(argv[i], "--help") == 0) {
       printf("Uso: %s [opciones]\n", argv[0]);
       printf("Opciones:\n");
@@ -303,7 +565,11 @@ int main(int argc, char* argv[]) {
       printf("  --no-lock    Inicia sin verificar instancias (para debugging)\n");
       printf("  --kill       Solo termina instancias existentes\n");
       printf("  --quiet      Modo silencioso\n");
+      printf("  --render=B   Backend de texto: xft (defecto), xrender o shm\n");
+      printf("  --max-fps=N  Frames por segundo máximos por barra (defecto 60, 0 = sin tope)\n");
+      printf("  --log-file=F Agrega el log a F en vez de stderr\n");
       printf("  --help       Muestra esta ayuda\n");
+      printf("\nStats: echo json | nc -U $XDG_RUNTIME_DIR/photonbar.sock, o kill -USR1 (a stderr)\n");
       return 0;
     }
   }
@@ -326,14 +592,18 @@ int main(int argc, char* argv[]) {
   // Setup de señales para cleanup elegante
   processManager.setupSignalHandlers();
 
-  // Inicializar BarManager
-  if (debug_log) {
-    fprintf(debug_log, "Iniciando inicialización secuencial de barras...\n");
-    fflush(debug_log);
+  // Entorno con el que arrancó (solo en builds de debug)
+  LOG_DEBUG("=== myBar Inicio === user=%s display=%s pwd=%s",
+            getenv("USER") ? getenv("USER") : "unknown",
+            getenv("DISPLAY") ? getenv("DISPLAY") : "unknown",
+            getenv("PWD") ? getenv("PWD") : "unknown");
+  for (int i = 0; i < argc; i++) {
+    LOG_DEBUG("arg[%d]=%s", i, argv[i]);
   }
 
-  // Crear módulos fuera de los hilos para evitar problemas de lifetime
+  // Los módulos viven todo el proceso
   static WorkspaceModule workspace_top;
+  static WindowTitleModule window_top;
   static AudioModule audio_top;
   static BatteryModule battery_top;
   static DateTimeModule datetime_top;
@@ -348,125 +618,56 @@ int main(int argc, char* argv[]) {
   static AudioModule audio_bottom;
   static ResourcesModule resources_bottom;
 
-  // Thread para inicializar y ejecutar barra superior
-  std::thread top_thread([debug_log]() {
-    std::vector<Module*> leftModules;
-    leftModules.push_back(&workspace_top);
-
-    std::vector<Module*> rightModules;
-    rightModules.push_back(&audio_top);
-    rightModules.push_back(&battery_top);
-    rightModules.push_back(&notifications_top);
-    rightModules.push_back(&weather_top);
-    rightModules.push_back(&datetime_top);
-
-    BarManager barTop(
-      "topBar",
-      true,
-      leftModules,
-      rightModules
-    );
-
-    // Registrar referencia global para callbacks
-    {
-      std::lock_guard<std::mutex> lock(gBarManagerMutex);
-      gBarManagers[0] = &barTop;
-    }
+  std::vector<Module*> topLeftModules;
+  topLeftModules.push_back(&workspace_top);
+  topLeftModules.push_back(&window_top);
 
-    if (debug_log) {
-      FILE* debug = fopen("/tmp/myBar_debug.log", "a");
-      fprintf(debug, "Iniciando inicialización barra superior...\n");
-      fclose(debug);
-    }
+  std::vector<Module*> topRightModules;
+  topRightModules.push_back(&audio_top);
+  topRightModules.push_back(&battery_top);
+  topRightModules.push_back(&notifications_top);
+  topRightModules.push_back(&weather_top);
+  topRightModules.push_back(&datetime_top);
 
-    if (!barTop.initialize()) {
-      fprintf(stderr, "Failed to initialize top BarManager\n");
-      return;
-    }
+  std::vector<Module*> bottomLeftModules;
+  bottomLeftModules.push_back(&timer_bottom);
+  bottomLeftModules.push_back(&stopwatch_bottom);
 
-    if (debug_log) {
-      FILE* debug = fopen("/tmp/myBar_debug.log", "a");
-      fprintf(debug, "Barra superior lista, iniciando run()...\n");
-      fclose(debug);
-    }
+  std::vector<Module*> bottomRightModules;
+  bottomRightModules.push_back(&space_bottom);
+  bottomRightModules.push_back(&resources_bottom);
+  bottomRightModules.push_back(&ping_bottom);
 
-    barTop.run();
-  });
+  // Antes de que el loop cree los workers: SIGUSR1 va al signalfd de stats
+  StatsServer::blockSignal();
 
-  // Esperar a que la barra superior esté completamente inicializada
-  {
-    std::unique_lock<std::mutex> lock(gInitMutex);
-    gInitCv.wait(lock, []{ return gTopReady; });
+  BarLoop loop;
+  if (!loop.setup()) {
+    return 1;
   }
 
-  if (debug_log) {
-    fprintf(debug_log, "Barra superior lista, iniciando barra inferior...\n");
-    fflush(debug_log);
-  }
+  // La barra inferior abre sus ventanas sobre la conexión de la superior
+  BarManager barTop(loop, "topBar", true, topLeftModules, topRightModules);
+  BarManager barBottom(loop, "bottomBar", false, bottomLeftModules, bottomRightModules, &barTop);
 
-  // Thread para inicializar y ejecutar barra inferior
-  std::thread bottom_thread([debug_log]() {
-    std::vector<Module*> leftModules;
-    leftModules .push_back(&timer_bottom);
-    leftModules .push_back(&stopwatch_bottom);
-
-    std::vector<Module*> rightModules;
-    rightModules.push_back(&space_bottom);
-    rightModules.push_back(&resources_bottom);
-    rightModules.push_back(&ping_bottom);
-
-    BarManager barBottom(
-      "bottomBar",
-      false,
-      leftModules,
-      rightModules
-    );
-
-    // Registrar referencia global para callbacks
-    {
-      std::lock_guard<std::mutex> lock(gBarManagerMutex);
-      gBarManagers[1] = &barBottom;
-    }
-
-    if (debug_log) {
-      FILE* debug = fopen("/tmp/myBar_debug.log", "a");
-      fprintf(debug, "Iniciando inicialización barra inferior...\n");
-      fclose(debug);
-    }
-
-    if (!barBottom.initialize()) {
-      fprintf(stderr, "Failed to initialize bottom BarManager\n");
-      return;
-    }
-
-    if (debug_log) {
-      FILE* debug = fopen("/tmp/myBar_debug.log", "a");
-      fprintf(debug, "Barra inferior lista, iniciando run()...\n");
-      fclose(debug);
-    }
-
-    barBottom.run();
-  });
-
-  if (debug_log) {
-    fprintf(debug_log, "Ambas barras en ejecución en hilos separados\n");
-    fflush(debug_log);
+  if (!barTop.initialize()) {
+    LOG_ERROR("Failed to initialize top BarManager");
+    return 1;
   }
+  loop.add(&barTop);
 
-  if (debug_log) {
-    fprintf(debug_log, "Ambas barras iniciadas, esperando...\n");
-    fflush(debug_log);
+  if (!barBottom.initialize()) {
+    LOG_ERROR("Failed to initialize bottom BarManager");
+    return 1;
   }
+  loop.add(&barBottom);
 
-  // Esperar a que los hilos terminen
-  top_thread.join();
-  bottom_thread.join();
+  LOG_DEBUG("Ambas barras inicializadas, iniciando loop");
+
+  loop.run();
 
   // Cleanup al salir (normalmente no se llega aquí por signal handlers)
-  if (debug_log) {
-    fprintf(debug_log, "Cleanup final - myBar terminando\n");
-    fclose(debug_log);
-  }
+  LOG_DEBUG("Cleanup final - myBar terminando");
   processManager.cleanup();
   return 0;
 }
@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <poll.h>
 #include <pulse/pulseaudio.h>
 #include <pulse/error.h>
 #include <vector>
@@ -11,9 +12,11 @@
 #include <algorithm>
 #include <cmath>
 #include <chrono> // Necesario para el control de tiempo
+#include <atomic>
 
 #include "module.h"
 #include "../helper.h"
+#include "../elementWriter.h"
 
 struct SinkInfo {
     std::string name;
@@ -26,8 +29,9 @@ struct SinkInfo {
 
 class AudioModule : public Module {
 public:
-    // Mantenemos el estándar de tu barra
-    AudioModule() : Module("audio", false, 5) {
+    // Los cambios llegan por la suscripción a PulseAudio; el intervalo solo
+    // refresca la batería bluetooth, que upower no notifica por acá
+    AudioModule() : Module("audio", false, 30) {
         baseElement.moduleName = name;
 
         baseElement.setEvent(BarElement::CLICK_LEFT, [this]() { toggleMute(); });
@@ -43,17 +47,24 @@ public:
     bool initialize() override { return initPa(); }
 
     void update() override {
-        auto now = std::chrono::steady_clock::now();
+        refreshCache();
+        updateElement();
+    }
 
-        // OPTIMIZACIÓN 1: Solo refrescar la info pesada cada 250ms
-        // Esto reduce el uso de CPU un 5000% si tu loop es de 5ms
-        if (std::chrono::duration_cast<std::chrono::milliseconds>(now - lastUpdate).count() < 250) {
-            return;
-        }
+    void eventFds(std::vector<int> &fds) override {
+        fds.insert(fds.end(), paFds.begin(), paFds.end());
+    }
+
+    bool handleEvent(int fd) override {
+        // Despachar todo lo que PulseAudio tenga pendiente, sin bloquear
+        while (pa_mainloop_iterate(mainloop, 0, NULL) > 0) {}
+        if (!paChanged) return false;
+        paChanged = false;
 
+        uint32_t before = elementsHash();
         refreshCache();
         updateElement();
-        lastUpdate = now;
+        return elementsHash() != before;
     }
 
 private:
@@ -64,13 +75,31 @@ private:
     std::string defaultSinkName;
     BarElement baseElement;
 
+    // fds que usa el mainloop de PulseAudio, capturados en pollCapture
+    std::vector<int> paFds;
+    bool paChanged = false;
+
+    // Cambios optimistas sin confirmar. Mientras haya operaciones en vuelo
+    // el estado del servidor llega atrasado (el evento de la muesca N
+    // después de mandar N+1 y N+2): se muestra el objetivo y no lo que
+    // trae refreshCache, así un scroll rápido no pierde ni revierte pasos.
+    struct PendingChange {
+        int ops = 0;            // operaciones sin respuesta
+        uint32_t sinkIndex = 0; // sink al que apuntan
+    };
+    PendingChange pendingVolume;
+    PendingChange pendingMute;
+    int targetVolume = 0;
+    bool targetMuted = false;
+
     // Variables para control de rendimiento
-    std::chrono::steady_clock::time_point lastUpdate;
     std::chrono::steady_clock::time_point lastBatteryCheck;
-    int cachedBattery = -1;
+    std::atomic<int> cachedBattery{-1};   // lo escribe el worker
+    bool batteryQueryInFlight = false;
 
     bool initPa() {
         mainloop = pa_mainloop_new();
+        pa_mainloop_set_poll_func(mainloop, pollCapture, this);
         context = pa_context_new(pa_mainloop_get_api(mainloop), "ModuleAudioContext");
         if (pa_context_connect(context, NULL, PA_CONTEXT_NOFLAGS, NULL) < 0) return false;
 
@@ -80,9 +109,29 @@ private:
             if (state == PA_CONTEXT_READY) break;
             if (state == PA_CONTEXT_FAILED || state == PA_CONTEXT_TERMINATED) return false;
         }
+
+        // Cambios de volumen, mute y sink por defecto llegan como eventos
+        pa_context_set_subscribe_callback(context, subscribe_callback, this);
+        pa_operation* o = pa_context_subscribe(context,
+            (pa_subscription_mask_t)(PA_SUBSCRIPTION_MASK_SINK | PA_SUBSCRIPTION_MASK_SERVER), NULL, NULL);
+        if (o) pa_operation_unref(o);
         return true;
     }
 
+    // Poll de PulseAudio: hace lo mismo que el original pero se guarda los
+    // fds para que el BarManager los escuche con su epoll
+    static int pollCapture(struct pollfd *ufds, unsigned long nfds, int timeout, void *userdata) {
+        AudioModule* self = static_cast<AudioModule*>(userdata);
+        self->paFds.clear();
+        for (unsigned long i = 0; i < nfds; i++)
+            self->paFds.push_back(ufds[i].fd);
+        return poll(ufds, nfds, timeout);
+    }
+
+    static void subscribe_callback(pa_context *c, pa_subscription_event_type_t t, uint32_t idx, void *userdata) {
+        static_cast<AudioModule*>(userdata)->paChanged = true;
+    }
+
     void cleanupPa() {
         if (context) { pa_context_disconnect(context); pa_context_unref(context); }
         if (mainloop) { pa_mainloop_free(mainloop); }
@@ -114,6 +163,18 @@ private:
         static_cast<AudioModule*>(userdata)->defaultSinkName = i->default_sink_name;
     }
 
+    // Respuesta de un set de volumen o mute. Con la última confirmada se
+    // vuelve a leer el estado real.
+    static void volume_done(pa_context *c, int success, void *userdata) {
+        AudioModule* self = static_cast<AudioModule*>(userdata);
+        if (--self->pendingVolume.ops == 0) self->paChanged = true;
+    }
+
+    static void mute_done(pa_context *c, int success, void *userdata) {
+        AudioModule* self = static_cast<AudioModule*>(userdata);
+        if (--self->pendingMute.ops == 0) self->paChanged = true;
+    }
+
     void refreshCache() {
         allSinks.clear();
         pa_operation* o = pa_context_get_server_info(context, server_info_callback, this);
@@ -124,39 +185,77 @@ private:
         o = pa_context_get_sink_info_list(context, sink_info_callback, this);
         while (pa_operation_get_state(o) == PA_OPERATION_RUNNING) pa_mainloop_iterate(mainloop, 0, NULL);
         pa_operation_unref(o);
+
+        // Lo que falta confirmar pisa al estado (atrasado) del servidor
+        if (pendingVolume.ops > 0 && pendingVolume.sinkIndex == currentSink.index)
+            currentSink.volume = targetVolume;
+        if (pendingMute.ops > 0 && pendingMute.sinkIndex == currentSink.index)
+            currentSink.isMuted = targetMuted;
     }
 
+    // Devuelve el último nivel conocido al instante. Si tiene más de 30s,
+    // la consulta a upower se lanza en el pool y el elemento se actualiza
+    // cuando vuelve.
     int getBluetoothBatteryLevel(const std::string& sinkName) {
         auto now = std::chrono::steady_clock::now();
         // OPTIMIZACIÓN 3: Cache de batería. Solo ejecutar upower cada 30 segundos.
         // upower es el proceso que consume 32% de tu CPU según el reporte.
-        if (cachedBattery != -1 && std::chrono::duration_cast<std::chrono::seconds>(now - lastBatteryCheck).count() < 30) {
+        if (batteryQueryInFlight ||
+            std::chrono::duration_cast<std::chrono::seconds>(now - lastBatteryCheck).count() < 30) {
             return cachedBattery;
         }
 
+        batteryQueryInFlight = true;
+        lastBatteryCheck = now;
+        runAsync(
+            [this]() { cachedBattery = queryUpowerBattery(); },
+            [this]() {
+                batteryQueryInFlight = false;
+                if (!currentSink.isBluetooth) return false;
+                uint32_t before = elementsHash();
+                currentSink.batteryLevel = cachedBattery;
+                updateElement();
+                return elementsHash() != before;
+            }
+        );
+        return cachedBattery;
+    }
+
+    // Corre en un worker
+    static int queryUpowerBattery() {
         // Simplificamos el comando para evitar múltiples pipes
-        std::string cmd = "upower -i $(upower -e | grep -E 'bluez|headset|audio' | head -1) 2>/dev/null | grep 'percentage' | awk '{print $2}' | tr -d '%' || echo '-1'";
+        const char* cmd = "upower -i $(upower -e | grep -E 'bluez|headset|audio' | head -1) 2>/dev/null | grep 'percentage' | awk '{print $2}' | tr -d '%' || echo '-1'";
 
-        FILE* pipe = popen(cmd.c_str(), "r");
+        FILE* pipe = popen(cmd, "r");
         if (!pipe) return -1;
 
+        int level = -1;
         char buffer[16];
         if (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
-            cachedBattery = atoi(buffer);
+            level = atoi(buffer);
         }
         pclose(pipe);
-        lastBatteryCheck = now;
-        return cachedBattery;
+        return level;
     }
 
-    // Funciones de interacción se mantienen igual para no romper la lógica
+    // Manda la operación sin esperar la respuesta. Cuenta en pending hasta
+    // que llega el callback de éxito (volume_done/mute_done); recién ahí el
+    // estado del servidor vuelve a mandar.
+    void sendOperation(pa_operation* o, PendingChange& pending) {
+        if (!o) return;
+        pending.sinkIndex = currentSink.index;
+        pending.ops++;
+        pa_operation_unref(o);
+        pa_mainloop_iterate(mainloop, 0, NULL);
+    }
+
+    // Mute y volumen se muestran en el momento (optimista): un scroll rápido
+    // no espera un round trip a PulseAudio por cada muesca
     void toggleMute() {
-        pa_operation* o = pa_context_set_sink_mute_by_index(context, currentSink.index, !currentSink.isMuted, NULL, NULL);
-        if (o) {
-            while (pa_operation_get_state(o) == PA_OPERATION_RUNNING) pa_mainloop_iterate(mainloop, 0, NULL);
-            pa_operation_unref(o);
-        }
-        refreshCache();
+        currentSink.isMuted = !currentSink.isMuted;
+        targetMuted = currentSink.isMuted;
+        sendOperation(pa_context_set_sink_mute_by_index(context, currentSink.index, targetMuted, mute_done, this),
+                      pendingMute);
         updateElement();
         if (renderFunction) renderFunction();
     }
@@ -180,39 +279,34 @@ private:
     }
 
     void adjustVolume(int delta) {
-        int new_volume = std::max(0, currentSink.volume + delta);
+        currentSink.volume = std::max(0, currentSink.volume + delta);
+        targetVolume = currentSink.volume;
         pa_cvolume cv;
-        pa_cvolume_set(&cv, 1, (pa_volume_t)((double)PA_VOLUME_NORM * new_volume / 100));
-        pa_operation* o = pa_context_set_sink_volume_by_index(context, currentSink.index, &cv, NULL, NULL);
-        if (o) {
-            while (pa_operation_get_state(o) == PA_OPERATION_RUNNING) pa_mainloop_iterate(mainloop, 0, NULL);
-            pa_operation_unref(o);
-        }
-        refreshCache();
+        pa_cvolume_set(&cv, 1, (pa_volume_t)((double)PA_VOLUME_NORM * targetVolume / 100));
+        sendOperation(pa_context_set_sink_volume_by_index(context, currentSink.index, &cv, volume_done, this),
+                      pendingVolume);
         updateElement();
         if (renderFunction) renderFunction();
     }
 
     void updateElement() {
-        const char* icon = getIcon(currentSink.name);
-        if (currentSink.isBluetooth && currentSink.batteryLevel >= 0) {
-            baseElement.contentLen = snprintf(baseElement.content, CONTENT_MAX_LEN, "%s %s %d%%",
-                Helper::getBatteryIcon(currentSink.batteryLevel), icon, currentSink.volume);
-        } else {
-            baseElement.contentLen = snprintf(baseElement.content, CONTENT_MAX_LEN, "%s %d%%",
-                icon, currentSink.volume);
-        }
-        baseElement.content[baseElement.contentLen] = '\0';
-        baseElement.dirtyContent = true;
+        ElementWriter out(baseElement);
+        if (currentSink.isBluetooth && currentSink.batteryLevel >= 0)
+            out.text(Helper::getBatteryIcon(currentSink.batteryLevel)).ch(' ');
+        out.icon(getIcon(currentSink.name)).ch(' ').integer(currentSink.volume).ch('%');
+        out.commit();
         baseElement.foregroundColor = currentSink.isMuted ?
             Color::parse_color("#FF6B6B", NULL, Color(255, 107, 107, 255)) :
             Color::parse_color("#E0AAFF", NULL, Color(224, 170, 255, 255));
     }
 
-    const char* getIcon(const std::string& name) {
-        if (name.find("bluez") != std::string::npos) return u8"\U000f02cb";
-        if (name.find("alsa") != std::string::npos) return "\ue638";
-        return "\xef\x90\x9c";
+    static const Icon& getIcon(const std::string& name) {
+        static const Icon bluetooth(u8"\U000f02cb");
+        static const Icon alsa("\ue638");
+        static const Icon speaker("\xef\x90\x9c");
+        if (name.find("bluez") != std::string::npos) return bluetooth;
+        if (name.find("alsa") != std::string::npos) return alsa;
+        return speaker;
     }
 };
 
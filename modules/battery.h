@@ -4,19 +4,70 @@
 #include <stdio.h>
 #include <string.h>
 #include <time.h>
+#include <limits.h>
+#include <unistd.h>
+#include <string>
+#include <sys/socket.h>
+#include <linux/netlink.h>
 #include "module.h"
+#include "../log.h"
 #include "../helper.h"
+#include "../elementWriter.h"
 #include "../notifyManeger.h"
 
 class BatteryModule : public Module {
 public:
-  BatteryModule() : Module("battery", false, 5) {
+  // Enchufar/desenchufar y los cambios de capacidad llegan como uevents; el
+  // intervalo solo refresca la estimación de tiempo restante
+  BatteryModule(const SystemPaths& paths = SystemPaths()) :
+    Module("battery", false, 60),
+    supplyPath(paths.sys + "/class/power_supply/BAT0")
+  {
     iconElement.moduleName = name;
     textElement.moduleName = name;
     elements.push_back(&iconElement);
     elements.push_back(&textElement);
   }
 
+  ~BatteryModule() {
+    if (ueventFd != -1) close(ueventFd);
+  }
+
+  bool initialize() override {
+    ueventFd = openUeventSocket();
+    if (ueventFd == -1) {
+      LOG_WARN("[battery] uevent socket unavailable, polling every 5s");
+      setSecondsPerUpdate(5);
+    }
+    return true;
+  }
+
+  void eventFds(std::vector<int> &fds) override {
+    if (ueventFd != -1) fds.push_back(ueventFd);
+  }
+
+  bool handleEvent(int fd) override {
+    char buf[4096];
+    ssize_t n;
+    bool powerSupply = false;
+
+    // Cada mensaje es "accion@devpath\0CLAVE=valor\0..."
+    while ((n = recv(ueventFd, buf, sizeof(buf) - 1, MSG_DONTWAIT)) > 0) {
+      buf[n] = '\0';
+      for (char* p = buf; p < buf + n; p += strlen(p) + 1) {
+        if (strcmp(p, "SUBSYSTEM=power_supply") == 0) {
+          powerSupply = true;
+          break;
+        }
+      }
+    }
+    if (!powerSupply) return false;
+
+    uint32_t before = elementsHash();
+    update();
+    return elementsHash() != before;
+  }
+
   void update() override {
     // Cacheamos los valores de los archivos de sistema
     energyNow  = readLong("energy_now", "charge_now");
@@ -37,6 +88,8 @@ public:
 
 private:
   BarElement iconElement, textElement;
+  std::string supplyPath;
+  int ueventFd = -1;
   long energyNow = 0, energyFull = 0, powerNow = 0;
   char status[16] = "Unknown";
   float percentage = 0.0f;
@@ -48,16 +101,17 @@ private:
     const bool isCharging = (status[0] == 'C');
 
     // 1. Icono y Texto
-    snprintf(iconElement.content, CONTENT_MAX_LEN, "%s ", Helper::getBatteryIcon(percentage, isCharging));
+    ElementWriter(iconElement).text(Helper::getBatteryIcon(percentage, isCharging)).ch(' ').commit();
 
+    ElementWriter text(textElement);
+    text.fixed(percentage, 1).ch('%');
     if (powerNow > 0 && (isCharging || status[0] == 'D')) {
       float timeFloat = isCharging ? (float)(energyFull - energyNow) / powerNow
         : (float)energyNow / powerNow;
       int totalMins = (int)(timeFloat * 60);
-      snprintf(textElement.content, CONTENT_MAX_LEN, "%.1f%% %02d:%02d", percentage, totalMins / 60, totalMins % 60);
-    } else {
-      snprintf(textElement.content, CONTENT_MAX_LEN, "%.1f%%", percentage);
+      text.ch(' ').integer(totalMins / 60, 2).ch(':').integer(totalMins % 60, 2);
     }
+    text.commit();
 
     // 2. Colores (Estética original preservada)
     if (isCharging) {
@@ -77,9 +131,6 @@ private:
     } else {
       textElement.foregroundColor = Color::parse_color("#E0AAFF", NULL, Color(224, 170, 255, 255));
     }
-
-    iconElement.dirtyContent = true;
-    textElement.dirtyContent = true;
   }
 
   void checkBatteryAlert() {
@@ -95,14 +146,29 @@ private:
     }
   }
 
+  // Socket netlink con los uevents del kernel (grupo 1, no hace falta udev)
+  int openUeventSocket() {
+    int fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_KOBJECT_UEVENT);
+    if (fd == -1) return -1;
+
+    struct sockaddr_nl addr = {};
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = 1;
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) == -1) {
+      close(fd);
+      return -1;
+    }
+    return fd;
+  }
+
   // Funciones de utilidad ligeras
   long readLong(const char* f1, const char* f2) {
-    char path[64];
+    char path[PATH_MAX];
     long val = 0;
-    snprintf(path, sizeof(path), "/sys/class/power_supply/BAT0/%s", f1);
+    snprintf(path, sizeof(path), "%s/%s", supplyPath.c_str(), f1);
     FILE* f = fopen(path, "r");
     if (!f && f2) {
-      snprintf(path, sizeof(path), "/sys/class/power_supply/BAT0/%s", f2);
+      snprintf(path, sizeof(path), "%s/%s", supplyPath.c_str(), f2);
       f = fopen(path, "r");
     }
     if (f) {
@@ -113,7 +179,9 @@ private:
   }
 
   void readStatus() {
-    FILE* f = fopen("/sys/class/power_supply/BAT0/status", "r");
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/status", supplyPath.c_str());
+    FILE* f = fopen(path, "r");
     if (f) {
       if (fscanf(f, "%15s", status) != 1) strcpy(status, "Unknown");
       fclose(f);
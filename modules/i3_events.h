@@ -0,0 +1,156 @@
+#ifndef I3_EVENTS_H
+#define I3_EVENTS_H
+
+#include <stdio.h>
+#include <algorithm>
+#include <vector>
+
+#define I3IPC_IMPLEMENTATION
+#include "i3ipc.h"
+
+// Interesados en eventos de i3. Los views apuntan al buffer de recepción y
+// valen solo durante la llamada; por eso en los callbacks de eventos no se
+// le hacen pedidos a i3, eso queda para afterI3Events.
+class I3EventListener {
+  public:
+    virtual ~I3EventListener() {}
+
+    // true si el evento cambió algo visible
+    virtual bool onWorkspaceEvent(const I3ipc_event_workspace_view& ev) { return false; }
+    virtual bool onWindowEvent(const I3ipc_event_window_view& ev) { return false; }
+
+    // Después de repartir todos los eventos pendientes
+    virtual bool afterI3Events() { return false; }
+
+    // La conexión con i3 se reabrió: lo que se tenía cacheado ya no vale
+    virtual void onI3Reconnect() {}
+
+    // Algo visible del listener cambió: pedir un frame a su propia barra.
+    // El hub lo llama después de repartir, una vez por listener.
+    virtual void requestI3Render() = 0;
+};
+
+// i3ipc.h tiene una sola conexión global con un solo socket de eventos, así
+// que varios módulos no pueden leerlo cada uno por su lado. El hub suscribe
+// la unión de los tipos pedidos, decodifica cada evento una sola vez y lo
+// reparte. Solo se usa desde el hilo de las barras.
+class I3EventHub {
+  public:
+    static I3EventHub& instance() {
+      static I3EventHub hub;
+      return hub;
+    }
+
+    void listen(I3EventListener* listener, int eventType) {
+      if (listeners.empty()) {
+        // Un error de i3 (p.ej. un reinicio) no debe abortar la barra
+        i3ipc_set_nopanic(true);
+        // Las respuestas de los comandos usan buffers internos reutilizables
+        // en vez de un malloc por mensaje
+        i3ipc_set_staticalloc(true);
+      }
+      listeners.push_back({listener, eventType});
+
+      if (std::find(eventTypes.begin(), eventTypes.end(), eventType) == eventTypes.end()) {
+        eventTypes.push_back(eventType);
+        subscribe(&eventType, 1);
+      }
+    }
+
+    // -1 si no hay conexión con i3
+    int fd() const {
+      return eventFd;
+    }
+
+    // Lee y reparte todos los eventos pendientes. Una ráfaga de eventos
+    // (p.ej. alt-tab sostenido) se aplica entera y se dibuja una sola vez.
+    // Cada listener que cambió pide el frame a su barra: el que llama no
+    // tiene por qué ser de la misma barra que los que cambiaron.
+    void dispatch() {
+      changed.clear();
+
+      // Cada llamada lee un mensaje completo (cabecera + payload), así un
+      // evento nunca queda partido entre dos lecturas
+      I3ipc_message* msg;
+      while (!i3ipc_event_next_message_try(0, &msg) && msg) {
+        if (msg->message_type == I3IPC_EVENT_WORKSPACE) {
+          I3ipc_event_workspace_view ev;
+          if (i3ipc_stream_workspace_event_try(msg, &ev)) break;
+          for (const Listener& l : listeners) {
+            if (l.eventType == I3IPC_EVENT_WORKSPACE && l.listener->onWorkspaceEvent(ev))
+              markChanged(l.listener);
+          }
+        } else if (msg->message_type == I3IPC_EVENT_WINDOW) {
+          I3ipc_event_window_view ev;
+          if (i3ipc_stream_window_event_try(msg, &ev)) break;
+          for (const Listener& l : listeners) {
+            if (l.eventType == I3IPC_EVENT_WINDOW && l.listener->onWindowEvent(ev))
+              markChanged(l.listener);
+          }
+        }
+      }
+
+      if (i3ipc_error_code()) {
+        i3ipc_error_print("[i3] event");
+        reconnect();
+        for (const Listener& l : listeners)
+          markChanged(l.listener);
+      } else {
+        I3EventListener* last = nullptr;
+        for (const Listener& l : listeners) {
+          if (l.listener == last) continue;
+          if (l.listener->afterI3Events()) markChanged(l.listener);
+          last = l.listener;
+        }
+      }
+
+      for (I3EventListener* listener : changed)
+        listener->requestI3Render();
+    }
+
+    // i3 cerró el socket (reinicio o salida): abrir una conexión nueva y
+    // volver a suscribir todo lo que se había pedido
+    void reconnect() {
+      if (i3ipc_error_code()) i3ipc_error_reinitialize(true);
+      subscribe(eventTypes.data(), eventTypes.size());
+      if (eventFd == -1) return;
+
+      I3EventListener* last = nullptr;
+      for (const Listener& l : listeners) {
+        // Un listener suscripto a varios tipos se avisa una sola vez
+        if (l.listener == last) continue;
+        l.listener->onI3Reconnect();
+        last = l.listener;
+      }
+    }
+
+  private:
+    struct Listener {
+      I3EventListener* listener;
+      int eventType;
+    };
+
+    std::vector<Listener> listeners;
+    std::vector<I3EventListener*> changed; // del dispatch en curso, sin repetir
+    std::vector<int> eventTypes;
+    int eventFd = -1;
+
+    I3EventHub() {}
+
+    void markChanged(I3EventListener* listener) {
+      if (std::find(changed.begin(), changed.end(), listener) == changed.end())
+        changed.push_back(listener);
+    }
+
+    void subscribe(int* types, int count) {
+      i3ipc_subscribe(types, count);
+      if (i3ipc_error_code()) {
+        i3ipc_error_print("[i3] subscribe");
+        eventFd = -1;
+        return;
+      }
+      eventFd = i3ipc_event_fd();
+    }
+};
+
+#endif // I3_EVENTS_H
@@ -643,6 +643,98 @@ int i3ipc_parse_try(I3ipc_message* msg, int message_type, int type_id, char** ou
 void i3ipc_printjson(int type_id, void* obj, FILE* f);
 
 
+/* *** Streaming API ***
+ * A pull parser that walks the json payload of a received message exactly once. Unlike
+ * i3ipc_parse_try it neither builds a token array nor allocates result structures: strings
+ * are decoded in place and handed out as views into the receive buffer (NUL-terminated,
+ * valid until the next message is received). Callers that want to collect values across
+ * members carve them out of an I3ipc_arena they own.
+ * Functions ending with _try follow the conventions of the low-level API. */
+
+typedef struct I3ipc_arena {
+    char*  base;
+    size_t size;
+    size_t used;
+} I3ipc_arena;
+
+/* Return size bytes from the arena, or NULL if it is full. This never allocates. */
+void* i3ipc_arena_alloc(I3ipc_arena* arena, size_t size, size_t alignment);
+
+/* Release everything handed out by the arena, keeping its memory. */
+void i3ipc_arena_reset(I3ipc_arena* arena);
+
+typedef struct I3ipc_reader {
+    char* cur;
+    int   left;
+    bool  err_flag;
+    I3ipc_arena* arena; /* may be NULL, for use by visitors */
+} I3ipc_reader;
+
+/* A visitor is called with the reader positioned at the value of the member named key.
+ * It must consume exactly that value and return 0 on success. */
+typedef int (*I3ipc_visit_fn)(I3ipc_reader* r, void* user);
+typedef struct I3ipc_visitor {
+    char const*    key;
+    I3ipc_visit_fn visit;
+} I3ipc_visitor;
+
+/* Position the reader at the start of the payload of msg. arena may be NULL. */
+void i3ipc_reader_init(I3ipc_reader* r, I3ipc_message* msg, I3ipc_arena* arena);
+
+/* Iterate over the members of an object or the elements of an array, like
+ *     for (int i = 0; i3ipc_reader_object(r, &i, &key); ++i) { ...consume the value... }
+ * The loop ends at the closing bracket, or on malformed input with r->err_flag set. */
+bool i3ipc_reader_object(I3ipc_reader* r, int* io_iter, I3ipc_string* out_key);
+bool i3ipc_reader_array(I3ipc_reader* r, int* io_iter);
+
+/* Read a single value. null reads as an empty string (str is NULL), 0 or false. */
+int i3ipc_reader_string_try(I3ipc_reader* r, I3ipc_string* out_str);
+int i3ipc_reader_int_try(I3ipc_reader* r, int64_t* out_val);
+int i3ipc_reader_bool_try(I3ipc_reader* r, bool* out_flag);
+
+/* Skip over a value of any type without decoding it. */
+int i3ipc_reader_skip_try(I3ipc_reader* r);
+
+/* Read an object, calling the visitor whose key matches each member and skipping the rest. */
+int i3ipc_reader_visit_try(I3ipc_reader* r, I3ipc_visitor const* visitors, int visitors_size, void* user);
+
+/* The members of a workspace or container node that the streaming decoders extract. */
+typedef struct I3ipc_node_view {
+    bool   set;
+    size_t id;
+    int    num;         /* workspaces only, -1 if unset */
+    I3ipc_string name;
+    I3ipc_string output;
+    I3ipc_string window_class;
+    I3ipc_string window_title;
+    bool   focused;
+    bool   urgent;
+    int    children_size; /* elements of nodes and floating_nodes, which are skipped */
+} I3ipc_node_view;
+
+typedef struct I3ipc_event_workspace_view {
+    int change_enum; /* see I3ipc_event_workspace_values, -1 if unknown */
+    I3ipc_node_view current;
+    I3ipc_node_view old;
+} I3ipc_event_workspace_view;
+
+typedef struct I3ipc_event_window_view {
+    int change_enum; /* see I3ipc_event_window_values, -1 if unknown */
+    I3ipc_node_view container;
+} I3ipc_event_window_view;
+
+/* Wait for the next event and return the raw message, without parsing it.
+ * out_msg is set to NULL if timeout_ms elapses. See i3ipc_event_next for timeout_ms. */
+int i3ipc_event_next_message_try(int timeout_ms, I3ipc_message** out_msg);
+
+/* Decode a workspace or window event. Nested nodes are skipped, not parsed. */
+int i3ipc_stream_workspace_event_try(I3ipc_message* msg, I3ipc_event_workspace_view* out_ev);
+int i3ipc_stream_window_event_try(I3ipc_message* msg, I3ipc_event_window_view* out_ev);
+
+/* Query the workspaces and call visit once per workspace, in the order i3 sends them. */
+int i3ipc_get_workspaces_stream_try(void (*visit)(I3ipc_node_view const* ws, void* user), void* user);
+
+
 enum I3ipc_message_type {
     I3IPC_RUN_COMMAND       =  0,
     I3IPC_GET_WORKSPACES    =  1,
@@ -2927,35 +3019,47 @@ void i3ipc_sync(int random_value, size_t window) {
     return;
 }
 
-I3ipc_event* i3ipc_event_next(int timeout_ms) {
-    if (i3ipc_error_code()) return NULL;
-    
-    struct pollfd fd;
-    memset(&fd, 0, sizeof(fd));
-    fd.fd = i3ipc_event_fd();
-    fd.events = POLLIN;
+int i3ipc_event_next_message_try(int timeout_ms, I3ipc_message** out_msg) {
+    assert(out_msg);
+    *out_msg = NULL;
+    if (i3ipc_error_code()) return I3IPC_ERROR_BADSTATE;
 
-    int code = poll(&fd, 1, timeout_ms);
-    if (code == -1) {
-        i3ipc__error_errno("while calling poll()");
-        i3ipc__error_handle(I3IPC_ERROR_IO);
-        return NULL;
-    } else if (code == 0) {
-        return NULL;
-    } else {
-        assert(code == 1);
-        assert(!(fd.events & POLLNVAL));
-        if (fd.events & POLLIN) {
-            /* fall through */
-        } else if (fd.events & (POLLERR | POLLHUP)) {
-            i3ipc__error_handle(I3IPC_ERROR_CLOSED);
-            return NULL;
+    I3ipc_context* context = &i3ipc__global_context;
+    if (!context->events_queued) {
+        /* Events already queued by i3ipc_message_receive_reorder_try are not visible to poll() */
+        struct pollfd fd;
+        memset(&fd, 0, sizeof(fd));
+        fd.fd = i3ipc_event_fd();
+        fd.events = POLLIN;
+
+        int code = poll(&fd, 1, timeout_ms);
+        if (code == -1) {
+            i3ipc__error_errno("while calling poll()");
+            return i3ipc__error_handle(I3IPC_ERROR_IO);
+        } else if (code == 0) {
+            return 0;
+        } else {
+            assert(code == 1);
+            assert(!(fd.events & POLLNVAL));
+            if (fd.events & POLLIN) {
+                /* fall through */
+            } else if (fd.events & (POLLERR | POLLHUP)) {
+                return i3ipc__error_handle(I3IPC_ERROR_CLOSED);
+            }
         }
     }
 
     I3ipc_message* msg;
     {int code = i3ipc_message_receive_reorder_try(I3IPC_EVENT_ANY, &msg);
-    if (code) return NULL;}
+    if (code) return code;}
+
+    *out_msg = msg;
+    return 0;
+}
+
+I3ipc_event* i3ipc_event_next(int timeout_ms) {
+    I3ipc_message* msg;
+    if (i3ipc_event_next_message_try(timeout_ms, &msg) || !msg) return NULL;
 
     int type = i3ipc__message_type_to_event(msg->message_type);
     if (type == -1) {
@@ -2974,4 +3078,408 @@ I3ipc_event* i3ipc_event_next(int timeout_ms) {
     return reply;
 }
 
+/* *** Streaming API *** */
+
+void* i3ipc_arena_alloc(I3ipc_arena* arena, size_t size, size_t alignment) {
+    assert(arena);
+    assert(alignment && !(alignment & (alignment-1)));
+    uintptr_t begin = (uintptr_t)arena->base;
+    uintptr_t p = (begin + arena->used + alignment-1) & ~(uintptr_t)(alignment-1);
+    size_t off = p - begin;
+    if (off > arena->size || arena->size - off < size) return NULL;
+    arena->used = off + size;
+    return arena->base + off;
+}
+
+void i3ipc_arena_reset(I3ipc_arena* arena) {
+    assert(arena);
+    arena->used = 0;
+}
+
+void i3ipc_reader_init(I3ipc_reader* r, I3ipc_message* msg, I3ipc_arena* arena) {
+    assert(r && msg);
+    r->cur = (char*)(msg + 1);
+    r->left = msg->message_length;
+    r->err_flag = false;
+    r->arena = arena;
+}
+
+/* Skip whitespace and return the next character without consuming it, 0 at the end */
+char i3ipc__reader_peek(I3ipc_reader* r) {
+    while (r->left) {
+        char c = *r->cur;
+        if (!(c == ' ' || c == '\t' || c == '\n' || c == '\r')) return c;
+        ++r->cur;
+        --r->left;
+    }
+    return 0;
+}
+
+void i3ipc__reader_advance(I3ipc_reader* r, int n) {
+    assert(n <= r->left);
+    r->cur  += n;
+    r->left -= n;
+}
+
+bool i3ipc__reader_literal(I3ipc_reader* r, char const* lit, int lit_size) {
+    if (r->left < lit_size || memcmp(r->cur, lit, lit_size)) return false;
+    i3ipc__reader_advance(r, lit_size);
+    return true;
+}
+
+bool i3ipc_reader_object(I3ipc_reader* r, int* io_iter, I3ipc_string* out_key) {
+    assert(r && io_iter);
+    char c = i3ipc__reader_peek(r);
+    if (*io_iter == 0) {
+        if (c != '{') goto err;
+        i3ipc__reader_advance(r, 1);
+        if (i3ipc__reader_peek(r) == '}') {
+            i3ipc__reader_advance(r, 1);
+            return false;
+        }
+    } else if (c == '}') {
+        i3ipc__reader_advance(r, 1);
+        return false;
+    } else {
+        if (c != ',') goto err;
+        i3ipc__reader_advance(r, 1);
+    }
+
+    {I3ipc_string key;
+    if (i3ipc__reader_peek(r) != '"' || i3ipc_reader_string_try(r, &key)) goto err;
+    if (i3ipc__reader_peek(r) != ':') goto err;
+    i3ipc__reader_advance(r, 1);
+    if (out_key) *out_key = key;}
+    return true;
+
+  err:
+    r->err_flag = true;
+    return false;
+}
+
+bool i3ipc_reader_array(I3ipc_reader* r, int* io_iter) {
+    assert(r && io_iter);
+    char c = i3ipc__reader_peek(r);
+    if (*io_iter == 0) {
+        if (c != '[') goto err;
+        i3ipc__reader_advance(r, 1);
+        if (i3ipc__reader_peek(r) == ']') {
+            i3ipc__reader_advance(r, 1);
+            return false;
+        }
+    } else if (c == ']') {
+        i3ipc__reader_advance(r, 1);
+        return false;
+    } else {
+        if (c != ',') goto err;
+        i3ipc__reader_advance(r, 1);
+    }
+    return true;
+
+  err:
+    r->err_flag = true;
+    return false;
+}
+
+int i3ipc_reader_string_try(I3ipc_reader* r, I3ipc_string* out_str) {
+    assert(r);
+    I3ipc_string str = {NULL, 0};
+    char c = i3ipc__reader_peek(r);
+    if (c == '"') {
+        /* Decoded in place, the result is shifted over the opening quote */
+        I3ipc_json_state state;
+        memset(&state, 0, sizeof(state));
+        state.cur  = r->cur;
+        state.left = r->left;
+        str.str = r->cur;
+        str.str_size = i3ipc__json_scan_string(&state);
+        r->cur  = state.cur;
+        r->left = state.left;
+    } else if (!i3ipc__reader_literal(r, "null", 4)) {
+        return 1;
+    }
+    if (out_str) *out_str = str;
+    return 0;
+}
+
+int i3ipc_reader_int_try(I3ipc_reader* r, int64_t* out_val) {
+    assert(r);
+    uint64_t val = 0;
+    char c = i3ipc__reader_peek(r);
+    if (c == 'n') {
+        if (!i3ipc__reader_literal(r, "null", 4)) return 1;
+    } else {
+        bool flipsign = c == '-';
+        if (flipsign) i3ipc__reader_advance(r, 1);
+        if (!r->left || !('0' <= *r->cur && *r->cur <= '9')) return 2;
+        for (; r->left && '0' <= *r->cur && *r->cur <= '9'; i3ipc__reader_advance(r, 1)) {
+            val = 10 * val + (*r->cur - '0');
+        }
+        /* Fractions are truncated */
+        if (r->left && *r->cur == '.') {
+            i3ipc__reader_advance(r, 1);
+            while (r->left && '0' <= *r->cur && *r->cur <= '9') i3ipc__reader_advance(r, 1);
+        }
+        if (r->left && (*r->cur == 'e' || *r->cur == 'E')) {
+            /* Exponents are not supported, i3 should not do this */
+            fprintf(i3ipc__err, "found json number with exponent, this is unsupported\n");
+            return 3;
+        }
+        if (flipsign) val = -val;
+    }
+    if (out_val) *out_val = (int64_t)val;
+    return 0;
+}
+
+int i3ipc_reader_bool_try(I3ipc_reader* r, bool* out_flag) {
+    assert(r);
+    bool flag = false;
+    char c = i3ipc__reader_peek(r);
+    if (c == 't') {
+        if (!i3ipc__reader_literal(r, "true", 4)) return 1;
+        flag = true;
+    } else if (c == 'f') {
+        if (!i3ipc__reader_literal(r, "false", 5)) return 2;
+    } else if (!i3ipc__reader_literal(r, "null", 4)) {
+        return 3;
+    }
+    if (out_flag) *out_flag = flag;
+    return 0;
+}
+
+int i3ipc_reader_skip_try(I3ipc_reader* r) {
+    assert(r);
+    char c = i3ipc__reader_peek(r);
+    if (c == '{') {
+        for (int i = 0; i3ipc_reader_object(r, &i, NULL); ++i) {
+            if (i3ipc_reader_skip_try(r)) return 4;
+        }
+        if (r->err_flag) return 9;
+    } else if (c == '[') {
+        for (int i = 0; i3ipc_reader_array(r, &i); ++i) {
+            if (i3ipc_reader_skip_try(r)) return 4;
+        }
+        if (r->err_flag) return 9;
+    } else if (c == '"') {
+        /* Find the closing quote, without decoding anything */
+        int i;
+        for (i = 1; i < r->left && r->cur[i] != '"'; ++i) {
+            if (r->cur[i] == '\\') ++i;
+        }
+        if (i >= r->left) return 5;
+        i3ipc__reader_advance(r, i+1);
+    } else if (c == '-' || ('0' <= c && c <= '9')) {
+        return i3ipc_reader_int_try(r, NULL);
+    } else if (c == 't' || c == 'f') {
+        return i3ipc_reader_bool_try(r, NULL);
+    } else if (!i3ipc__reader_literal(r, "null", 4)) {
+        return 1;
+    }
+    return 0;
+}
+
+int i3ipc_reader_visit_try(I3ipc_reader* r, I3ipc_visitor const* visitors, int visitors_size, void* user) {
+    assert(r && (visitors || !visitors_size));
+    I3ipc_string key;
+    for (int i = 0; i3ipc_reader_object(r, &i, &key); ++i) {
+        I3ipc_visitor const* visitor = NULL;
+        for (int j = 0; j < visitors_size; ++j) {
+            if (strcmp(visitors[j].key, key.str) == 0) {
+                visitor = &visitors[j];
+                break;
+            }
+        }
+        int code = visitor ? visitor->visit(r, user) : i3ipc_reader_skip_try(r);
+        if (code) return code;
+    }
+    return r->err_flag ? 9 : 0;
+}
+
+int i3ipc__stream_enum(I3ipc_reader* r, char const* const* names, int names_size, int* out_enum) {
+    I3ipc_string str;
+    if (i3ipc_reader_string_try(r, &str)) return 1;
+    *out_enum = -1;
+    for (int i = 0; str.str && i < names_size; ++i) {
+        if (strcmp(names[i], str.str) == 0) {
+            *out_enum = i;
+            break;
+        }
+    }
+    return 0;
+}
+
+int i3ipc__stream_node_id(I3ipc_reader* r, void* user) {
+    int64_t val;
+    if (i3ipc_reader_int_try(r, &val)) return 1;
+    ((I3ipc_node_view*)user)->id = (size_t)val;
+    return 0;
+}
+int i3ipc__stream_node_num(I3ipc_reader* r, void* user) {
+    int64_t val = -1;
+    if (i3ipc_reader_int_try(r, &val)) return 1;
+    ((I3ipc_node_view*)user)->num = (int)val;
+    return 0;
+}
+int i3ipc__stream_node_name(I3ipc_reader* r, void* user) {
+    return i3ipc_reader_string_try(r, &((I3ipc_node_view*)user)->name);
+}
+int i3ipc__stream_node_output(I3ipc_reader* r, void* user) {
+    return i3ipc_reader_string_try(r, &((I3ipc_node_view*)user)->output);
+}
+int i3ipc__stream_node_focused(I3ipc_reader* r, void* user) {
+    return i3ipc_reader_bool_try(r, &((I3ipc_node_view*)user)->focused);
+}
+int i3ipc__stream_node_urgent(I3ipc_reader* r, void* user) {
+    return i3ipc_reader_bool_try(r, &((I3ipc_node_view*)user)->urgent);
+}
+int i3ipc__stream_node_class(I3ipc_reader* r, void* user) {
+    return i3ipc_reader_string_try(r, &((I3ipc_node_view*)user)->window_class);
+}
+int i3ipc__stream_node_title(I3ipc_reader* r, void* user) {
+    return i3ipc_reader_string_try(r, &((I3ipc_node_view*)user)->window_title);
+}
+int i3ipc__stream_node_children(I3ipc_reader* r, void* user) {
+    I3ipc_node_view* node = (I3ipc_node_view*)user;
+    for (int i = 0; i3ipc_reader_array(r, &i); ++i) {
+        if (i3ipc_reader_skip_try(r)) return 1;
+        ++node->children_size;
+    }
+    return r->err_flag;
+}
+int i3ipc__stream_node_window_properties(I3ipc_reader* r, void* user) {
+    static I3ipc_visitor const visitors[] = {
+        {"class", i3ipc__stream_node_class},
+        {"title", i3ipc__stream_node_title}
+    };
+    if (i3ipc__reader_peek(r) == 'n') return !i3ipc__reader_literal(r, "null", 4);
+    return i3ipc_reader_visit_try(r, visitors, sizeof(visitors) / sizeof(visitors[0]), user);
+}
+
+/* Children ("nodes", "floating_nodes", ...) are skipped */
+int i3ipc__stream_node(I3ipc_reader* r, I3ipc_node_view* node) {
+    static I3ipc_visitor const visitors[] = {
+        {"id",                i3ipc__stream_node_id},
+        {"num",               i3ipc__stream_node_num},
+        {"name",              i3ipc__stream_node_name},
+        {"output",            i3ipc__stream_node_output},
+        {"focused",           i3ipc__stream_node_focused},
+        {"urgent",            i3ipc__stream_node_urgent},
+        {"window_properties", i3ipc__stream_node_window_properties},
+        {"nodes",             i3ipc__stream_node_children},
+        {"floating_nodes",    i3ipc__stream_node_children}
+    };
+    memset(node, 0, sizeof(*node));
+    node->num = -1;
+    if (i3ipc__reader_peek(r) == 'n') return !i3ipc__reader_literal(r, "null", 4);
+    node->set = true;
+    return i3ipc_reader_visit_try(r, visitors, sizeof(visitors) / sizeof(visitors[0]), node);
+}
+
+static char const* const i3ipc__global_workspace_change_name[] = {
+    "focus", "init", "empty", "urgent", "reload", "rename", "restored", "move"
+};
+static char const* const i3ipc__global_window_change_name[] = {
+    "new", "close", "focus", "title", "fullscreen_mode", "move", "floating", "urgent", "mark"
+};
+
+int i3ipc__stream_workspace_change(I3ipc_reader* r, void* user) {
+    int size = sizeof(i3ipc__global_workspace_change_name) / sizeof(i3ipc__global_workspace_change_name[0]);
+    return i3ipc__stream_enum(r, i3ipc__global_workspace_change_name, size,
+        &((I3ipc_event_workspace_view*)user)->change_enum);
+}
+int i3ipc__stream_workspace_current(I3ipc_reader* r, void* user) {
+    return i3ipc__stream_node(r, &((I3ipc_event_workspace_view*)user)->current);
+}
+int i3ipc__stream_workspace_old(I3ipc_reader* r, void* user) {
+    return i3ipc__stream_node(r, &((I3ipc_event_workspace_view*)user)->old);
+}
+int i3ipc__stream_window_change(I3ipc_reader* r, void* user) {
+    int size = sizeof(i3ipc__global_window_change_name) / sizeof(i3ipc__global_window_change_name[0]);
+    return i3ipc__stream_enum(r, i3ipc__global_window_change_name, size,
+        &((I3ipc_event_window_view*)user)->change_enum);
+}
+int i3ipc__stream_window_container(I3ipc_reader* r, void* user) {
+    return i3ipc__stream_node(r, &((I3ipc_event_window_view*)user)->container);
+}
+
+int i3ipc__stream_check_type(I3ipc_message* msg, int message_type) {
+    assert(msg);
+    if (msg->message_type == message_type) return 0;
+    fprintf(i3ipc__err, "message type does not match, expected %s(%x), got %s(%x)\n",
+        i3ipc__message_type_str(message_type, true), message_type,
+        i3ipc__message_type_str(msg->message_type, true), msg->message_type);
+    return i3ipc__error_handle(I3IPC_ERROR_MALFORMED);
+}
+
+int i3ipc_stream_workspace_event_try(I3ipc_message* msg, I3ipc_event_workspace_view* out_ev) {
+    static I3ipc_visitor const visitors[] = {
+        {"change",  i3ipc__stream_workspace_change},
+        {"current", i3ipc__stream_workspace_current},
+        {"old",     i3ipc__stream_workspace_old}
+    };
+    assert(out_ev);
+    {int code = i3ipc__stream_check_type(msg, I3IPC_EVENT_WORKSPACE);
+    if (code) return code;}
+
+    memset(out_ev, 0, sizeof(*out_ev));
+    out_ev->change_enum = -1;
+    out_ev->current.num = -1;
+    out_ev->old.num = -1;
+
+    I3ipc_reader r;
+    i3ipc_reader_init(&r, msg, NULL);
+    if (i3ipc_reader_visit_try(&r, visitors, sizeof(visitors) / sizeof(visitors[0]), out_ev)) {
+        fprintf(i3ipc__err, "while parsing workspace event\n");
+        return i3ipc__error_handle(I3IPC_ERROR_MALFORMED);
+    }
+    return 0;
+}
+
+int i3ipc_stream_window_event_try(I3ipc_message* msg, I3ipc_event_window_view* out_ev) {
+    static I3ipc_visitor const visitors[] = {
+        {"change",    i3ipc__stream_window_change},
+        {"container", i3ipc__stream_window_container}
+    };
+    assert(out_ev);
+    {int code = i3ipc__stream_check_type(msg, I3IPC_EVENT_WINDOW);
+    if (code) return code;}
+
+    memset(out_ev, 0, sizeof(*out_ev));
+    out_ev->change_enum = -1;
+    out_ev->container.num = -1;
+
+    I3ipc_reader r;
+    i3ipc_reader_init(&r, msg, NULL);
+    if (i3ipc_reader_visit_try(&r, visitors, sizeof(visitors) / sizeof(visitors[0]), out_ev)) {
+        fprintf(i3ipc__err, "while parsing window event\n");
+        return i3ipc__error_handle(I3IPC_ERROR_MALFORMED);
+    }
+    return 0;
+}
+
+int i3ipc_get_workspaces_stream_try(void (*visit)(I3ipc_node_view const* ws, void* user), void* user) {
+    assert(visit);
+    if (i3ipc_error_code()) return I3IPC_ERROR_BADSTATE;
+
+    I3ipc_message* msg;
+    {int code = i3ipc_message_try(I3IPC_GET_WORKSPACES, NULL, 0, &msg);
+    if (code) return code;}
+
+    I3ipc_reader r;
+    i3ipc_reader_init(&r, msg, NULL);
+    I3ipc_node_view ws;
+    for (int i = 0; i3ipc_reader_array(&r, &i); ++i) {
+        if (i3ipc__stream_node(&r, &ws)) {
+            r.err_flag = true;
+            break;
+        }
+        visit(&ws, user);
+    }
+    if (r.err_flag) {
+        fprintf(i3ipc__err, "while parsing workspaces reply\n");
+        return i3ipc__error_handle(I3IPC_ERROR_MALFORMED);
+    }
+    return 0;
+}
+
 #endif /* I3IPC_IMPLEMENTATION */
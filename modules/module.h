@@ -8,10 +8,32 @@
 #include <ctime>
 #include <algorithm>
 #include <cstring>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <time.h>
 #include "../barElement.h"
 
+// Reloj monótono en milisegundos, la base de todos los deadlines del scheduler
+inline int64_t monotonicMs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// Raíces de /proc y /sys de las que leen los módulos de sistema. Por defecto
+// las reales; bench/module_bench.cpp las apunta a fixtures generados.
+struct SystemPaths {
+  std::string proc = "/proc";
+  std::string sys = "/sys";
+};
+
 // Forward declaration
 class BarManager;
+struct ModuleStats;
+
+// Manda work a un hilo del pool; done vuelve a correr en el hilo de render
+typedef std::function<void(std::function<void()> work, std::function<bool()> done)> AsyncFunction;
 
 class Module {
   public:
@@ -27,59 +49,144 @@ class Module {
       return name;
     }
 
-    std::vector<BarElement*> getElements() {
-      return elements;
+    // Los módulos bloqueantes escriben sus elementos desde un worker; la
+    // barra dibuja la copia publicada (ver publishElements)
+    // Por referencia: la barra la recorre varias veces por frame
+    const std::vector<BarElement*>& getElements() const {
+      return blockingUpdate ? frontElements : elements;
+    }
+
+    // Elemento i de la misma lista, sin copiarla; nullptr si ya no existe
+    BarElement* elementAt(size_t i) const {
+      const std::vector<BarElement*>& list = blockingUpdate ? frontElements : elements;
+      return i < list.size() ? list[i] : nullptr;
+    }
+
+    bool isBlocking() const {
+      return blockingUpdate;
     }
 
     virtual void update() = 0;
     virtual bool initialize() { return true; } // Default implementation for modules that don't need initialization
 
-    // Métodos de control de actualización
-  //
-    bool shouldUpdate() {
-      if (autoUpdate) return true; // Actulizar por cada render
-      std::cout << "llegamos al should update" << std::endl;
-      time_t now = time(nullptr);
-      std::cout << "now: " << now << " lastUpdate: " << lastUpdate << " secondsPerUpdate: " << secondsPerUpdate << std::endl;
-      return (now - lastUpdate) >= secondsPerUpdate;
+    // Próximo instante (ms de monotonicMs) en el que el módulo necesita un
+    // update(). -1 = sin deadline, el módulo solo cambia por eventos.
+    virtual int64_t nextDeadline(int64_t nowMs) {
+      if (eventDriven || msPerUpdate <= 0) return -1;
+      if (!lastRunMs) return nowMs; // nunca corrió: vence ya
+      return lastRunMs + msPerUpdate;
     }
 
-    bool checkAndUpdate() {
-      if (shouldUpdate()) {
-        std::cout << "se actualiza el modulo " << name << std::endl;
-        update();
+    // fds propios que el BarManager multiplexa con epoll. Se vuelven a
+    // consultar después de cada handleEvent, así un módulo puede reabrirlos.
+    virtual void eventFds(std::vector<int> &fds) {}
+
+    // Se llama cuando fd tiene datos. true solo si el contenido visible
+    // cambió; si no, la barra no se redibuja.
+    virtual bool handleEvent(int fd) { return false; }
+
+    // Hash del contenido y estilo de lo que la barra dibuja del módulo
+    uint32_t elementsHash() const {
+      uint32_t h = 2166136261u;
+      for (const BarElement* element : blockingUpdate ? frontElements : elements)
+        h = (h ^ element->contentHash()) * 16777619u;
+      return h;
+    }
+
+    // Copia los elementos del módulo (back) a los que dibuja la barra (front).
+    // Solo desde el hilo de render. Si hay un trabajo en curso no espera: ese
+    // trabajo vuelve a publicar al terminar.
+    bool publishElements() {
+      std::unique_lock<std::mutex> lock(updateMutex, std::try_to_lock);
+      if (!lock.owns_lock()) return false;
+
+      uint32_t before = elementsHash();
+      if (frontStorage.size() != elements.size()) {
+        frontStorage.clear();
+        frontElements.clear();
+        for (BarElement* element : elements)
+          frontStorage.push_back(*element);
+        for (BarElement& element : frontStorage)
+          frontElements.push_back(&element);
         return true;
       }
-      return false;
+      for (size_t i = 0; i < elements.size(); i++)
+        frontStorage[i].copyContentFrom(*elements[i]);
+      return elementsHash() != before;
     }
 
     void setRenderFunction(std::function<void()> renderFunction) {
       this->renderFunction = renderFunction;
     }
 
+    void setAsyncFunction(AsyncFunction asyncFunction) {
+      this->asyncFunction = asyncFunction;
+    }
+
 
   protected:
-    void setAutoUpdate(bool enabled) { autoUpdate = enabled; }
-    void setSecondsPerUpdate(int seconds) { secondsPerUpdate = seconds; }
+    void setEventDriven(bool enabled) { eventDriven = enabled; scheduleChanged = true; }
+    void setSecondsPerUpdate(int seconds) { setMsPerUpdate(seconds * 1000); }
+    void setMsPerUpdate(int ms) { msPerUpdate = ms; scheduleChanged = true; }
+    void setBlockingUpdate(bool blocking) { blockingUpdate = blocking; }
+
+    // Corre work fuera del hilo de render y done de vuelta en él. Sin pool
+    // (p.ej. fuera de un BarManager) corre todo en el momento.
+    void runAsync(std::function<void()> work, std::function<bool()> done) {
+      if (asyncFunction) {
+        asyncFunction(work, done);
+      } else {
+        work();
+        if (done() && renderFunction) renderFunction();
+      }
+    }
+
+    // Para módulos bloqueantes: work modifica el estado del módulo con el
+    // lock tomado y el resultado se publica al terminar
+    void runBlocking(std::function<void()> work) {
+      runAsync(
+        [this, work]() {
+          std::lock_guard<std::mutex> lock(updateMutex);
+          work();
+        },
+        [this]() { return publishElements(); }
+      );
+    }
 
-    Module(std::string name, bool autoUpdate, int secondsPerUpdate) :
+    // eventDriven: el módulo nunca se sondea, solo cambia por sus eventFds
+    // (handleEvent). Si no, update() corre cada secondsPerUpdate.
+    Module(std::string name, bool eventDriven, int secondsPerUpdate) :
       fontIndex(-1),
       screenTarget(0),
-      secondsPerUpdate(secondsPerUpdate),
+      msPerUpdate(secondsPerUpdate * 1000),
       lastUpdate(0),
-      autoUpdate(autoUpdate),
+      eventDriven(eventDriven),
       name(name)
     {
     };
     std::function<void()> renderFunction;
+    AsyncFunction asyncFunction;
     // Configuración de actualización
     bool updatePerIteration;     // ¿Actualizar en cada ciclo?
-    int secondsPerUpdate;        // Intervalo en segundos
+    int msPerUpdate;             // Intervalo en milisegundos
 
     // Estado de actualización
     time_t lastUpdate;            // Timestamp de última actualización
     bool needsUpdate;             // Forzar actualización
-    bool autoUpdate;              // Control general de actualizaciones
+    bool eventDriven;             // Sin deadline: solo eventos, nunca sondeo
+
+    // Estado del scheduler (lo maneja BarManager)
+    int64_t lastRunMs = 0;        // Último update() disparado por deadline
+    int64_t scheduledAt = -1;     // Deadline vigente en el heap
+    bool scheduleChanged = false; // El intervalo cambió, hay que reprogramar
+    bool updateQueued = false;    // Update bloqueante esperando en el pool
+    ModuleStats* stats = nullptr; // Latencias de update/handleEvent (stats.h)
+
+    // Doble buffer de los módulos bloqueantes
+    bool blockingUpdate = false;
+    std::mutex updateMutex;             // tomado mientras un worker escribe
+    std::vector<BarElement> frontStorage;
+    std::vector<BarElement*> frontElements;
 
     std::string name;
     std::vector<BarElement*> elements;
@@ -4,8 +4,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <cstring>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/wait.h>
 #include "module.h"
+#include "../log.h"
 #include "../barElement.h"
+#include "../elementWriter.h"
 
 class NotificationsModule : public Module {
 private:
@@ -13,6 +18,42 @@ private:
     bool isPaused = false;
     int waitingCount = 0;
 
+    // Salida de dbus-monitor: cada línea es una notificación nueva o un
+    // cambio de estado de dunst
+    int dbusFd = -1;
+    pid_t dbusPid = -1;
+
+    int subscribeDbus() {
+        int pipefd[2];
+        if (pipe(pipefd) == -1) return -1;
+
+        pid_t pid = fork();
+        if (pid == -1) {
+            close(pipefd[0]);
+            close(pipefd[1]);
+            return -1;
+        }
+
+        if (pid == 0) {
+            close(pipefd[0]);
+            dup2(pipefd[1], STDOUT_FILENO);
+            close(pipefd[1]);
+            execlp("dbus-monitor", "dbus-monitor", "--session",
+                   "type='method_call',interface='org.freedesktop.Notifications',member='Notify'",
+                   "type='signal',interface='org.freedesktop.Notifications',member='NotificationClosed'",
+                   "type='signal',interface='org.freedesktop.DBus.Properties',member='PropertiesChanged',path='/org/freedesktop/Notifications'",
+                   NULL);
+            exit(1);
+        }
+
+        close(pipefd[1]);
+        int flags = fcntl(pipefd[0], F_GETFL, 0);
+        fcntl(pipefd[0], F_SETFL, flags | O_NONBLOCK);
+        fcntl(pipefd[0], F_SETFD, FD_CLOEXEC);
+        dbusPid = pid;
+        return pipefd[0];
+    }
+
     void updateState() {
         FILE* f = popen("dunstctl is-paused", "r");
         if (f) {
@@ -38,40 +79,80 @@ private:
     }
 
     void updateVisuals() {
+        static const Icon iconPaused(u8"\U000f009b");
+        static const Icon iconActive(u8"\U000f009c");
+
+        ElementWriter out(element);
         if (isPaused) {
-            if (waitingCount > 0) {
-                snprintf(element.content, CONTENT_MAX_LEN, u8"\U000f009b %d", waitingCount);
-            } else {
-                snprintf(element.content, CONTENT_MAX_LEN, u8"\U000f009b");
-            }
+            out.icon(iconPaused);
+            if (waitingCount > 0)
+                out.ch(' ').integer(waitingCount);
             element.foregroundColor = Color::parse_color("#FF6B6B", NULL, Color(255, 107, 107, 255));
         } else {
-            snprintf(element.content, CONTENT_MAX_LEN, u8"\U000f009c");
+            out.icon(iconActive);
             element.foregroundColor = Color::parse_color("#E0AAFF", NULL, Color(224, 170, 255, 255));
         }
-        element.dirtyContent = true;
+        out.commit();
     }
 
 public:
-    NotificationsModule() : Module("notifications", false, 0) {
+    NotificationsModule() : Module("notifications", false, 1) {
         element.moduleName = name;
 
+        // dunstctl se llama con popen: todo corre en el pool de workers
+        setBlockingUpdate(true);
+
         element.setEvent(BarElement::CLICK_LEFT, [this]() {
-            toggleNotifications();
-            if (renderFunction) {
-                renderFunction();
-            }
+            runBlocking([this]() { toggleNotifications(); });
         });
 
         elements.push_back(&element);
     }
 
+    ~NotificationsModule() {
+        if (dbusFd != -1) close(dbusFd);
+    }
+
     bool initialize() override {
+        dbusFd = subscribeDbus();
+        // Con la suscripción activa el polling queda como red de seguridad
+        if (dbusFd != -1) setSecondsPerUpdate(30);
         updateState();
         updateVisuals();
         return true;
     }
 
+    void eventFds(std::vector<int> &fds) override {
+        if (dbusFd != -1) fds.push_back(dbusFd);
+    }
+
+    bool handleEvent(int fd) override {
+        char buffer[4096];
+        ssize_t bytesRead;
+        bool gotData = false;
+
+        while ((bytesRead = read(dbusFd, buffer, sizeof(buffer))) > 0)
+            gotData = true;
+
+        // dbus-monitor terminó (o no existe): volver al polling de 1s en
+        // lugar de relanzarlo en loop
+        if (bytesRead == 0) {
+            close(dbusFd);
+            dbusFd = -1;
+            waitpid(dbusPid, NULL, 0);
+            LOG_WARN("[notifications] dbus-monitor exited, polling every 1s");
+            setSecondsPerUpdate(1);
+        }
+        if (!gotData) return false;
+
+        // El cambio se ve cuando el worker publica
+        runBlocking([this]() {
+            updateState();
+            updateVisuals();
+        });
+        return false;
+    }
+
     void update() override {
         updateState();
         updateVisuals();
@@ -10,18 +10,21 @@
 #include <poll.h>
 #include <arpa/inet.h>
 #include <sys/socket.h>
+#include <string>
+#include <vector>
 
 #include "module.h"
+#include "../elementWriter.h"
 
 class PingModule : public Module {
 private:
     bool showDetails = true;
-    const char* host = "8.8.8.8";
-    int port = 443;
+    const char* host;
+    int port;
 
-    static constexpr const char* ICON_NET  = "\uef09";
-    static constexpr const char* ICON_UP   = "\ueaa0";
-    static constexpr const char* ICON_DOWN = "\uea9d";
+    const Icon iconNet  = Icon("\uef09");
+    const Icon iconUp   = Icon("\ueaa0");
+    const Icon iconDown = Icon("\uea9d");
 
     unsigned long long lastSent = 0;
     unsigned long long lastRecv = 0;
@@ -34,7 +37,9 @@ private:
     BarElement baseElement;
 
     /* ================== /proc/net/dev ================== */
+    std::string netDevPath;
     int netDevFd = -1;
+    std::vector<char> netDevBuf;   // crece hasta que entra el archivo entero
 
     static inline unsigned long long fast_atoull(char*& p) {
         unsigned long long val = 0;
@@ -48,16 +53,25 @@ private:
 
     inline void openNetDev() {
         if (netDevFd >= 0) return;
-        netDevFd = open("/proc/net/dev", O_RDONLY | O_CLOEXEC);
+        netDevFd = open(netDevPath.c_str(), O_RDONLY | O_CLOEXEC);
     }
 
     inline void getNetworkIo(unsigned long long& sent, unsigned long long& recv) {
         if (netDevFd < 0) return;
-        if (lseek(netDevFd, 0, SEEK_SET) < 0) return;
 
-        char buf[4096]; // seguro para muchas interfaces
-        ssize_t len = read(netDevFd, buf, sizeof(buf) - 1);
-        if (len <= 0) return;
+        // Con muchas interfaces el archivo no entra en 4K: se lee con pread
+        // hasta EOF y el buffer se agranda una vez, no en cada update
+        if (netDevBuf.empty()) netDevBuf.resize(4096);
+        size_t len = 0;
+        for (;;) {
+            if (len + 1 >= netDevBuf.size()) netDevBuf.resize(netDevBuf.size() * 2);
+            ssize_t n = pread(netDevFd, &netDevBuf[len], netDevBuf.size() - len - 1, len);
+            if (n < 0) return;
+            if (n == 0) break;
+            len += n;
+        }
+        if (!len) return;
+        char* buf = &netDevBuf[0];
         buf[len] = '\0';
 
         sent = recv = 0;
@@ -143,7 +157,13 @@ private:
     }
 
 public:
-    PingModule() : Module("network", false, 1) {
+    PingModule(const SystemPaths& paths = SystemPaths(),
+               const char* host = "8.8.8.8", int port = 443) :
+        Module("network", false, 1),
+        host(host),
+        port(port),
+        netDevPath(paths.proc + "/net/dev")
+    {
         openNetDev();
         getNetworkIo(lastSent, lastRecv);
 
@@ -190,35 +210,18 @@ public:
             lastLatencyCheck = now;
         }
 
-        if (!showDetails) {
-            baseElement.contentLen = snprintf(
-                baseElement.content,
-                CONTENT_MAX_LEN,
-                "%s",
-                ICON_NET
-            );
-        } else if (cachedLatency >= 0.0f) {
-            baseElement.contentLen = snprintf(
-                baseElement.content,
-                CONTENT_MAX_LEN,
-                "%s %.1fms %s%.1fK %s%.1fK",
-                ICON_NET,
-                cachedLatency,
-                ICON_UP, up,
-                ICON_DOWN, down
-            );
-        } else {
-            baseElement.contentLen = snprintf(
-                baseElement.content,
-                CONTENT_MAX_LEN,
-                "%s Off %s%.1fK %s%.1fK",
-                ICON_NET,
-                ICON_UP, up,
-                ICON_DOWN, down
-            );
+        // La velocidad cambia casi en cada update, pero con los detalles
+        // ocultos el texto es fijo y no se vuelve a decodificar
+        ElementWriter out(baseElement);
+        out.icon(iconNet);
+        if (showDetails) {
+            out.ch(' ');
+            if (cachedLatency >= 0.0f) out.fixed(cachedLatency, 1).text("ms");
+            else out.text("Off");
+            out.ch(' ').icon(iconUp).fixed(up, 1).ch('K')
+               .ch(' ').icon(iconDown).fixed(down, 1).ch('K');
         }
-
-        baseElement.dirtyContent = true;
+        out.commit();
         lastUpdate = now;
     }
 };
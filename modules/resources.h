@@ -4,12 +4,16 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <dirent.h>
+#include <limits.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include <string>
+#include <vector>
 
 #include "module.h"
 #include "../barElement.h"
+#include "../elementWriter.h"
 #include "../color.h"
 
 class ResourcesModule : public Module {
@@ -19,10 +23,14 @@ class ResourcesModule : public Module {
     uint64_t lastCpuIdle  = 0;
 
     // ================= TEMP STATE =================
-    int tempFds[32];
-    int tempFdCount = 0;
+    std::vector<int> tempFds;
     bool tempInitialized = false;
 
+    // ================= PATHS =================
+    std::string meminfoPath;
+    std::string statPath;
+    std::string hwmonPath;
+
     // ================= UI ELEMENTS =================
     BarElement ramElement;
     BarElement cpuElement;
@@ -33,9 +41,9 @@ class ResourcesModule : public Module {
     Color colorAlert;
 
     // ================= ICONS =================
-    static constexpr const char* ICON_RAM  = "\uefc5";
-    static constexpr const char* ICON_CPU  = "\uf4bc";
-    static constexpr const char* ICON_TEMP = "\uf2c9";
+    const Icon iconRam  = Icon("\uefc5");
+    const Icon iconCpu  = Icon("\uf4bc");
+    const Icon iconTemp = Icon("\uf2c9");
 
     // ================= THRESHOLDS =================
     static constexpr float RAM_WARN  = 80.0f;
@@ -43,7 +51,12 @@ class ResourcesModule : public Module {
     static constexpr float TEMP_WARN = 70.0f;
 
   public:
-    ResourcesModule() : Module("resources", false, 2) {
+    ResourcesModule(const SystemPaths& paths = SystemPaths()) :
+      Module("resources", false, 2),
+      meminfoPath(paths.proc + "/meminfo"),
+      statPath(paths.proc + "/stat"),
+      hwmonPath(paths.sys + "/class/hwmon")
+    {
       // ---- cachear colores (MUY importante) ----
       colorNormal = Color::parse_color("#E0AAFF", nullptr, Color(224,170,255,255));
       colorAlert  = Color::parse_color("#FF6B6B", nullptr, Color(255,107,107,255));
@@ -65,13 +78,13 @@ class ResourcesModule : public Module {
     }
 
     ~ResourcesModule() {
-      for (int i = 0; i < tempFdCount; ++i)
-        close(tempFds[i]);
+      for (int fd : tempFds)
+        close(fd);
     }
 
     // ================= RAM =================
     float getRamUsage() {
-      FILE* f = fopen("/proc/meminfo", "r");
+      FILE* f = fopen(meminfoPath.c_str(), "r");
       if (!f) return 0.0f;
 
       char line[256];
@@ -92,7 +105,7 @@ class ResourcesModule : public Module {
 
     // ================= CPU =================
     float getCpuUsage() {
-      int fd = open("/proc/stat", O_RDONLY | O_CLOEXEC);
+      int fd = open(statPath.c_str(), O_RDONLY | O_CLOEXEC);
       if (fd < 0) return 0.0f;
 
       char buf[256];
@@ -129,40 +142,31 @@ class ResourcesModule : public Module {
     // ================= TEMP =================
     float getCpuTemp() {
       if (!tempInitialized) {
-        DIR* dir = opendir("/sys/class/hwmon");
+        DIR* dir = opendir(hwmonPath.c_str());
         if (dir) {
           struct dirent* ent;
-          while ((ent = readdir(dir)) && tempFdCount < 32) {
+          while ((ent = readdir(dir))) {
             if (ent->d_name[0] == '.') continue;
 
-            char base[128];
-            int blen = 0;
-            const char* p = "/sys/class/hwmon/";
-            while (*p) base[blen++] = *p++;
-            p = ent->d_name;
-            while (*p) base[blen++] = *p++;
-            base[blen] = '\0';
+            char base[PATH_MAX];
+            if (snprintf(base, sizeof(base), "%s/%s", hwmonPath.c_str(), ent->d_name) >= (int)sizeof(base))
+              continue;
 
             DIR* sub = opendir(base);
             if (!sub) continue;
 
             struct dirent* e2;
-            while ((e2 = readdir(sub)) && tempFdCount < 32) {
+            while ((e2 = readdir(sub))) {
               if (strncmp(e2->d_name, "temp", 4) != 0) continue;
               if (!strstr(e2->d_name, "_input")) continue;
 
-              char file[256];
-              int flen = 0;
-              p = base;
-              while (*p) file[flen++] = *p++;
-              file[flen++] = '/';
-              p = e2->d_name;
-              while (*p) file[flen++] = *p++;
-              file[flen] = '\0';
+              char file[PATH_MAX];
+              if (snprintf(file, sizeof(file), "%s/%s", base, e2->d_name) >= (int)sizeof(file))
+                continue;
 
               int fd = open(file, O_RDONLY | O_CLOEXEC);
               if (fd >= 0)
-                tempFds[tempFdCount++] = fd;
+                tempFds.push_back(fd);
             }
             closedir(sub);
           }
@@ -174,9 +178,9 @@ class ResourcesModule : public Module {
       int maxMilli = 0;
       char buf[16];
 
-      for (int i = 0; i < tempFdCount; ++i) {
-        lseek(tempFds[i], 0, SEEK_SET);
-        ssize_t n = read(tempFds[i], buf, sizeof(buf) - 1);
+      // pread: una syscall por sensor en vez de lseek + read
+      for (int fd : tempFds) {
+        ssize_t n = pread(fd, buf, sizeof(buf) - 1, 0);
         if (n <= 0) continue;
 
         buf[n] = '\0';
@@ -198,28 +202,16 @@ class ResourcesModule : public Module {
       float temp = getCpuTemp();
 
       // ---- RAM ----
-      ramElement.contentLen = snprintf(
-        ramElement.content, CONTENT_MAX_LEN,
-        "%s %.1f%% ▏", ICON_RAM, ram
-      );
+      ElementWriter(ramElement).icon(iconRam).ch(' ').fixed(ram, 1).text("% ▏").commit();
       ramElement.foregroundColor = (ram > RAM_WARN) ? colorAlert : colorNormal;
-      ramElement.dirtyContent = true;
 
       // ---- CPU ----
-      cpuElement.contentLen = snprintf(
-        cpuElement.content, CONTENT_MAX_LEN,
-        "%s %.1f%% ", ICON_CPU, cpu
-      );
+      ElementWriter(cpuElement).icon(iconCpu).ch(' ').fixed(cpu, 1).text("% ").commit();
       cpuElement.foregroundColor = (cpu > CPU_WARN) ? colorAlert : colorNormal;
-      cpuElement.dirtyContent = true;
 
       // ---- TEMP ----
-      tempElement.contentLen = snprintf(
-        tempElement.content, CONTENT_MAX_LEN,
-        " %s %.0f°C", ICON_TEMP, temp
-      );
+      ElementWriter(tempElement).ch(' ').icon(iconTemp).ch(' ').fixed(temp, 0).text("°C").commit();
       tempElement.foregroundColor = (temp > TEMP_WARN) ? colorAlert : colorNormal;
-      tempElement.dirtyContent = true;
 
       lastUpdate = time(nullptr);
     }
@@ -8,7 +8,9 @@
 #include <sys/statvfs.h>
 #include <string>
 #include "module.h"
+#include "../log.h"
 #include "../barElement.h"
+#include "../elementWriter.h"
 #include "../color.h"
 
 
@@ -35,7 +37,7 @@ class SpaceModule : public Module {
     void getSpaceUsage() {
       struct statvfs vfs;
       if (statvfs(partition.c_str(), &vfs) != 0) {
-        fprintf(stderr, "[SpaceModule] Error accessing %s\n", partition.c_str());
+        LOG_WARN("[SpaceModule] Error accessing %s", partition.c_str());
         freeGb = 0.0;
         usedPercentage = 0.0;
         cacheUntil = 0;
@@ -58,9 +60,9 @@ class SpaceModule : public Module {
 
 
   public:
-    SpaceModule():
-      Module("space", false, 30),  // No auto-update, cada 30 segundos
-      partition("/"),
+    SpaceModule(const std::string& partition = "/"):
+      Module("space", false, 30),  // Sondeo cada 30 segundos
+      partition(partition),
       name("\uf0c7"),
       displayMode(0)
     {
@@ -94,40 +96,14 @@ class SpaceModule : public Module {
     void update() override {
       getSpaceUsage();
 
-      // Generar texto según modo actual usando snprintf estándar
-      int mode_idx = displayMode % NUM_DISPLAY_MODES;
-      
-      switch(mode_idx) {
-        case DISPLAY_FREE:
-          baseElement.contentLen = snprintf(
-            baseElement.content,
-            CONTENT_MAX_LEN,
-            "%s %.2fGB",
-            name.c_str(),
-            freeGb
-          );
-          break;
-        case DISPLAY_USED_PERCENTAGE:
-          baseElement.contentLen = snprintf(
-            baseElement.content,
-            CONTENT_MAX_LEN,
-            "%s %.0f%%",
-            name.c_str(),
-            usedPercentage
-          );
-          break;
-        default:
-          baseElement.contentLen = snprintf(
-            baseElement.content,
-            CONTENT_MAX_LEN,
-            "%s %.2fGB",
-            name.c_str(),
-            freeGb
-          );
-          break;
-      }
-
-      baseElement.dirtyContent = true;
+      // Generar texto según modo actual
+      ElementWriter out(baseElement);
+      out.text(name.data(), name.size()).ch(' ');
+      if (displayMode % NUM_DISPLAY_MODES == DISPLAY_USED_PERCENTAGE)
+        out.fixed(usedPercentage, 0).ch('%');
+      else
+        out.fixed(freeGb, 2).text("GB");
+      out.commit();
 
       // Color fijo igual al original
       baseElement.foregroundColor = Color::parse_color("#E0AAFF", NULL, Color(224, 170, 255, 255));
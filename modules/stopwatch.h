@@ -5,6 +5,7 @@
 #include <stdio.h>
 #include <string.h>
 #include "module.h"
+#include "../elementWriter.h"
 #include "../color.h"
 
 class StopwatchModule : public Module {
@@ -24,9 +25,9 @@ private:
   bool showDetails = false;
   long long accumulatedPauseTime = 0;
 
-  static constexpr const char* ICON_PLAY = " \uf04b";
-  static constexpr const char* ICON_PAUSE = " \uf04c";
-  static constexpr const char* ICON_LOGO = "\uf2f2"; // Icono de reloj más común
+  const Icon iconPlay = Icon("\uf04b");
+  const Icon iconPause = Icon("\uf04c");
+  const Icon iconLogo = Icon("\uf2f2"); // Icono de reloj más común
 
   long long get_elapsed_ms() {
     if (!isRunning) return 0;
@@ -43,12 +44,12 @@ private:
     }
   }
 
-  void formatTime(char* buffer, size_t bufferSize, long long elapsedMs) {
+  void formatTime(ElementWriter& out, long long elapsedMs) {
     int hours = elapsedMs / 3600000;
     int minutes = (elapsedMs % 3600000) / 60000;
     int seconds = (elapsedMs % 60000) / 1000;
 
-    snprintf(buffer, bufferSize, "%02d:%02d:%02d", hours, minutes, seconds);
+    out.integer(hours, 2).ch(':').integer(minutes, 2).ch(':').integer(seconds, 2);
   }
 
   void playPause() {
@@ -145,41 +146,19 @@ public:
   void update() override {
     applyColors();
 
-    long long elapsed = get_elapsed_ms();
-    char time_buffer[64];
-    formatTime(time_buffer, sizeof(time_buffer), elapsed);
+    // Logo (siempre visible). El color no necesita dirtyContent: el
+    // estilo entra en el hash de render
+    ElementWriter(baseElement).icon(iconLogo).commit();
 
-    // Logo (siempre visible)
-    baseElement.contentLen = snprintf(
-      baseElement.content,
-      CONTENT_MAX_LEN,
-      "%s",
-      ICON_LOGO
-    );
-
-    // El logo siempre necesita actualizarse por cambios de color
-    baseElement.dirtyContent = true;
-
-    // Elemento de tiempo (solo visible en modo detallado)
+    // Elemento de tiempo (solo visible en modo detallado; oculto queda vacío)
+    ElementWriter out(timeElement);
     if (showDetails) {
-      const char* action_icon = "";
-      if (isRunning) {
-        action_icon = isPaused ? ICON_PLAY : ICON_PAUSE;
-      }
-
-      timeElement.contentLen = snprintf(
-        timeElement.content,
-        CONTENT_MAX_LEN,
-        "%s %s",
-        action_icon,
-        time_buffer
-      );
-      timeElement.dirtyContent = true;
-    } else {
-      // Ocultar elemento de tiempo en modo compacto
-      timeElement.contentLen = snprintf(timeElement.content, CONTENT_MAX_LEN, "");
-      timeElement.dirtyContent = true;  // Forzar actualización para ocultar
+      if (isRunning)
+        out.ch(' ').icon(isPaused ? iconPlay : iconPause);
+      out.ch(' ');
+      formatTime(out, get_elapsed_ms());
     }
+    out.commit();
 
     // Actualizar timestamp - CRÍTICO
     lastUpdate = time(nullptr);
@@ -5,6 +5,7 @@
 #include <stdio.h>
 #include <string.h>
 #include "module.h"
+#include "../elementWriter.h"
 #include "../color.h"
 #include "../notifyManeger.h"
 
@@ -31,9 +32,9 @@ private:
   long long targetDurationMs = 0;
   bool notificationSent = false;
 
-  static constexpr const char* ICON_PLAY  = " \uf04b";
-  static constexpr const char* ICON_PAUSE = " \uf04c";
-  static constexpr const char* ICON_LOGO  = u8"\U000f06ad";
+  const Icon iconPlay  = Icon("\uf04b");
+  const Icon iconPause = Icon("\uf04c");
+  const Icon iconLogo  = Icon(u8"\U000f06ad");
 
   // Ya no necesitamos esta función - el timer debe seguir corriendo visualmente
 
@@ -209,80 +210,27 @@ public:
     int minutes = (remaining % 3600000) / 60000;
     int seconds = (remaining % 60000) / 1000;
 
-    // Logo (siempre visible)
-    baseElement.contentLen = snprintf(
-      baseElement.content,
-      CONTENT_MAX_LEN,
-      "%s",
-      ICON_LOGO
-    );
+    // Logo (siempre visible). El color no necesita dirtyContent: el
+    // estilo entra en el hash de render
+    ElementWriter(baseElement).icon(iconLogo).commit();
 
-    // El logo siempre necesita actualizarse por cambios de color
-    baseElement.dirtyContent = true;
-
-    // Icono play/pause (solo visible cuando showDetails = true)
-    if (showDetails) {
-      if (!isRunning) {
-        // Cuando no está corriendo pero se muestra, mostrar play
-        playIconElement.contentLen = snprintf(
-          playIconElement.content,
-          CONTENT_MAX_LEN,
-          "%s ",
-          ICON_PLAY
-        );
-      } else {
-        // Cuando está corriendo, mostrar estado actual
-        const char* icon = isPaused ? ICON_PLAY : ICON_PAUSE;
-        playIconElement.contentLen = snprintf(
-          playIconElement.content,
-          CONTENT_MAX_LEN,
-          "%s ",
-          icon
-        );
-      }
-      playIconElement.dirtyContent = true;
-    } else {
-      // Ocultar playIcon cuando está en modo oculto (forzar actualización)
-      playIconElement.contentLen = snprintf(playIconElement.content, CONTENT_MAX_LEN, "");
-      playIconElement.dirtyContent = true;  // Forzar actualización para ocultar
-    }
-
-    // Elementos de tiempo
+    // Con los detalles ocultos los elementos quedan vacíos; el writer solo
+    // los marca el update en que se vacían
+    ElementWriter playIcon(playIconElement);
+    ElementWriter hour(hourElement);
+    ElementWriter minute(minuteElement);
+    ElementWriter second(secondElement);
     if (showDetails) {
-      hourElement.contentLen = snprintf(
-        hourElement.content,
-        CONTENT_MAX_LEN,
-        "-%02d:",
-        hours
-      );
-      hourElement.dirtyContent = true;
-
-      minuteElement.contentLen = snprintf(
-        minuteElement.content,
-        CONTENT_MAX_LEN,
-        "%02d:",
-        minutes
-      );
-      minuteElement.dirtyContent = true;
-
-      secondElement.contentLen = snprintf(
-        secondElement.content,
-        CONTENT_MAX_LEN,
-        "%02d",
-        seconds
-      );
-      secondElement.dirtyContent = true;
-    } else {
-      // Ocultar elementos de tiempo cuando está en modo oculto
-      hourElement.contentLen = snprintf(hourElement.content, CONTENT_MAX_LEN, "");
-      hourElement.dirtyContent = true;  // Forzar actualización para ocultar
-
-      minuteElement.contentLen = snprintf(minuteElement.content, CONTENT_MAX_LEN, "");
-      minuteElement.dirtyContent = true;  // Forzar actualización para ocultar
-
-      secondElement.contentLen = snprintf(secondElement.content, CONTENT_MAX_LEN, "");
-      secondElement.dirtyContent = true;  // Forzar actualización para ocultar
+      // Sin correr muestra play; corriendo, la acción del click
+      playIcon.ch(' ').icon(isRunning && !isPaused ? iconPause : iconPlay).ch(' ');
+      hour.ch('-').integer(hours, 2).ch(':');
+      minute.integer(minutes, 2).ch(':');
+      second.integer(seconds, 2);
     }
+    playIcon.commit();
+    hour.commit();
+    minute.commit();
+    second.commit();
 
     // Actualizar timestamp - CRÍTICO
     lastUpdate = time(nullptr);
@@ -11,8 +11,10 @@ using namespace std;
 #include <curl/curl.h>
 #include <json-c/json.h>
 #include "module.h"
+#include "../log.h"
 #include <fmt/format.h>
 #include "../barElement.h"
+#include "../elementWriter.h"
 
 class WeatherModule : public Module {
   private:
@@ -24,6 +26,7 @@ class WeatherModule : public Module {
     const double lon;
 
     // Estado del clima
+    static const time_t API_INTERVAL = 600;
     time_t lastApiCall;
     double temperature;
     double feelsLike;
@@ -67,7 +70,7 @@ class WeatherModule : public Module {
 
   public:
     WeatherModule():
-      Module("weather", false, 600),  // No auto-update, cada 600 segundos (10 min)
+      Module("weather", false, 600),  // Sondeo cada 600 segundos (10 min)
       lat(-34.4476799),    // Del Viso, Pilar, Buenos Aires
       lon(-58.8052387),    // Del Viso, Pilar, Buenos Aires
       lastApiCall(0),
@@ -88,13 +91,15 @@ class WeatherModule : public Module {
       // Configurar elemento base
       baseElement.moduleName = name;
 
-      // Click izquierdo: toggle detalles
+      // curl_easy_perform bloquea hasta 15s: update() corre en el pool
+      setBlockingUpdate(true);
+
+      // Click izquierdo: toggle detalles (sin volver a pedir datos)
       baseElement.setEvent(BarElement::CLICK_LEFT, [this]() {
-        showDetails = !showDetails;
-        update();
-        if (renderFunction) {
-          renderFunction();
-        }
+        runBlocking([this]() {
+          showDetails = !showDetails;
+          generateBuffer();
+        });
       });
 
       // Color base del texto
@@ -107,7 +112,7 @@ class WeatherModule : public Module {
       if (!curl_handle) {
         curl_handle = curl_easy_init();
         if (!curl_handle) {
-          fprintf(stderr, "[WeatherModule] Failed to initialize curl handle\n");
+          LOG_ERROR("[WeatherModule] Failed to initialize curl handle");
           return;
         }
 
@@ -130,7 +135,7 @@ class WeatherModule : public Module {
         curl_easy_setopt(curl_handle, CURLOPT_HEADERFUNCTION, HeaderCallback);
         curl_easy_setopt(curl_handle, CURLOPT_HEADERDATA, this);
 
-        fprintf(stderr, "[WeatherModule] Curl handle initialized with optimizations\n");
+        LOG_DEBUG("[WeatherModule] Curl handle initialized with optimizations");
       }
     }
 
@@ -141,9 +146,10 @@ class WeatherModule : public Module {
       curl_global_cleanup();
     }
 
+    // La primera llamada a la API la hace el primer update(), ya en el pool;
+    // hasta entonces el elemento queda vacío
     bool initialize() override {
-      // Realizar primera llamada a la API
-      return fetchWeatherData();
+      return true;
     }
 
     void update() override {
@@ -155,7 +161,7 @@ class WeatherModule : public Module {
       }
 
       // Solo llamar a la API si han pasado 10 minutos
-      if (fetchWeatherData()) {
+      if ((lastApiCall == 0 || now - lastApiCall >= API_INTERVAL) && fetchWeatherData()) {
         lastApiCall = now;
       }
 
@@ -166,7 +172,7 @@ class WeatherModule : public Module {
   private:
     bool fetchWeatherData() {
       if (!curl_handle) {
-        fprintf(stderr, "[WeatherModule] Curl handle not initialized\n");
+        LOG_ERROR("[WeatherModule] Curl handle not initialized");
         return false;
       }
 
@@ -198,16 +204,16 @@ class WeatherModule : public Module {
           // Datos nuevos recibidos
           success = parseWeatherJson(readBuffer);
           lastModified = time(nullptr); // Actualizar timestamp
-          fprintf(stderr, "[WeatherModule] Fresh data received (HTTP 200)\n");
+          LOG_DEBUG("[WeatherModule] Fresh data received (HTTP 200)");
         } else if (http_code == 304) {
           // Not Modified - usar cache existente
           success = true;
-          fprintf(stderr, "[WeatherModule] Using cached data (HTTP 304)\n");
+          LOG_DEBUG("[WeatherModule] Using cached data (HTTP 304)");
         } else {
-          fprintf(stderr, "[WeatherModule] HTTP error: %ld\n", http_code);
+          LOG_WARN("[WeatherModule] HTTP error: %ld", http_code);
         }
       } else {
-        fprintf(stderr, "[WeatherModule] Curl error: %s\n", curl_easy_strerror(res));
+        LOG_WARN("[WeatherModule] Curl error: %s", curl_easy_strerror(res));
       }
 
       return success;
@@ -216,13 +222,13 @@ class WeatherModule : public Module {
     bool parseWeatherJson(const std::string& json_str) {
       json_object *root = json_tokener_parse(json_str.c_str());
       if (!root) {
-        fprintf(stderr, "[WeatherModule] Failed to parse JSON\n");
+        LOG_WARN("[WeatherModule] Failed to parse JSON");
         return false;
       }
 
       json_object *current_weather;
       if (!json_object_object_get_ex(root, "current_weather", &current_weather)) {
-        fprintf(stderr, "[WeatherModule] No current_weather in JSON\n");
+        LOG_WARN("[WeatherModule] No current_weather in JSON");
         json_object_put(root);
         return false;
       }
@@ -269,7 +275,7 @@ class WeatherModule : public Module {
 
       json_object_put(root);
 
-      fprintf(stderr, "[WeatherModule] Weather updated: %.1f°C, code: %d\n",
+      LOG_DEBUG("[WeatherModule] Weather updated: %.1f°C, code: %d",
               temperature, weatherCode);
 
       return true;
@@ -308,27 +314,16 @@ class WeatherModule : public Module {
     }
 
     void generateBuffer() {
-      std::string content;
-
       // Icono del clima y temperatura principal
-      content += fmt::format("{} {:.1f}°C", getWeatherDescription(), temperature);
+      ElementWriter out(baseElement);
+      out.text(getWeatherDescription()).ch(' ').fixed(temperature, 1).text("°C");
 
       if (showDetails) {
-        content += fmt::format(
-          " | ST: {:.1f}°C | H: {}% | V: {:.1f}km/h",
-          feelsLike, humidity, windSpeed
-        );
+        out.text(" | ST: ").fixed(feelsLike, 1)
+           .text("°C | H: ").integer(humidity)
+           .text("% | V: ").fixed(windSpeed, 1).text("km/h");
       }
-
-      // Copiar al buffer del elemento
-      baseElement.contentLen = snprintf(
-        baseElement.content,
-        CONTENT_MAX_LEN,
-        "%s",
-        content.c_str()
-      );
-
-      baseElement.dirtyContent = true;
+      out.commit();
 
       // Cambiar color según estado
       if (temperature > 30) {
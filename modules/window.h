@@ -0,0 +1,167 @@
+#ifndef WINDOW_H
+#define WINDOW_H
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "i3_events.h"
+#include "module.h"
+
+// Título de la ventana enfocada. Todo sale de los eventos `window` de i3:
+// el payload ya trae el contenedor con su título, así que no hace falta un
+// GET_TREE por cambio de foco (solo uno al arrancar y al reconectar).
+//
+// El elemento pide truncate: la barra lo recorta al espacio libre entre los
+// módulos izquierdos y los derechos.
+class WindowTitleModule : public Module, public I3EventListener {
+  public:
+    WindowTitleModule() : Module("window", true, 1) {
+      element.moduleName = name;
+      element.truncate = true;
+      element.foregroundColor = Color::parse_color("#AAAAAA", NULL, Color(0xAA, 0xAA, 0xAA, 255));
+      elements.push_back(&element);
+    }
+
+    void update() {
+    }
+
+    bool initialize() {
+      I3EventHub& hub = I3EventHub::instance();
+      hub.listen(this, I3IPC_EVENT_WINDOW);
+      hub.listen(this, I3IPC_EVENT_WORKSPACE);
+      loadFocused();
+      return true;
+    }
+
+    void eventFds(std::vector<int> &fds) override {
+      int fd = I3EventHub::instance().fd();
+      if (fd != -1) fds.push_back(fd);
+    }
+
+    // El hub pide el frame a la barra de cada listener que cambió
+    bool handleEvent(int fd) override {
+      I3EventHub::instance().dispatch();
+      return false;
+    }
+
+    void requestI3Render() override {
+      if (renderFunction) renderFunction();
+    }
+
+    bool onWindowEvent(const I3ipc_event_window_view& ev) override {
+      const I3ipc_node_view& container = ev.container;
+      if (!container.set) return false;
+
+      switch (ev.change_enum) {
+        case I3IPC_WINDOW_CHANGE_FOCUS:
+          cacheTitle(container);
+          return showWindow(container.id);
+
+        case I3IPC_WINDOW_CHANGE_NEW:
+          // Todavía no tiene foco: solo se guarda el título
+          cacheTitle(container);
+          return false;
+
+        case I3IPC_WINDOW_CHANGE_TITLE:
+          // Un título que cambia en otra ventana no mueve nada en la barra
+          if (!cacheTitle(container) || container.id != focusedId) return false;
+          return showWindow(container.id);
+
+        case I3IPC_WINDOW_CHANGE_CLOSE:
+          titles.erase(container.id);
+          if (container.id != focusedId) return false;
+          return showWindow(0);
+
+        default:
+          return false;
+      }
+    }
+
+    bool onWorkspaceEvent(const I3ipc_event_workspace_view& ev) override {
+      // Pasar a un workspace vacío no genera evento de ventana
+      if (ev.change_enum == I3IPC_WORKSPACE_CHANGE_FOCUS &&
+          ev.current.set && ev.current.children_size == 0)
+        return showWindow(0);
+      return false;
+    }
+
+    void onI3Reconnect() override {
+      titles.clear();
+      loadFocused();
+    }
+
+  private:
+    BarElement element;
+    size_t focusedId = 0;                         // 0: ninguna ventana
+    std::unordered_map<size_t, std::string> titles;
+
+    // false si el título ya era ese
+    bool cacheTitle(const I3ipc_node_view& container) {
+      const char* title = container.name.str ? container.name.str : "";
+      std::string& cached = titles[container.id];
+      if (cached == title) return false;
+      cached = title;
+      return true;
+    }
+
+    // Cambia lo que muestra el elemento. Solo se toca (y se vuelve a parsear
+    // y medir) si cambió la ventana enfocada o su título.
+    bool showWindow(size_t id) {
+      const char* title = "";
+      if (id) {
+        auto it = titles.find(id);
+        if (it != titles.end()) title = it->second.c_str();
+      }
+
+      char content[CONTENT_MAX_LEN];
+      int len = *title ? snprintf(content, CONTENT_MAX_LEN - 1, " %s ", title) : 0;
+      // Un título largo se corta en un límite de carácter, no en medio de
+      // una secuencia UTF-8
+      if (len > CONTENT_MAX_LEN - 2) len = utf8Truncate(content, CONTENT_MAX_LEN - 2);
+      content[len] = '\0';
+
+      focusedId = id;
+      if (len == element.contentLen && strcmp(content, element.content) == 0)
+        return false;
+
+      memcpy(element.content, content, len + 1);
+      element.contentLen = len;
+      element.dirtyContent = true;
+      return true;
+    }
+
+    static const I3ipc_node* findFocused(const I3ipc_node* node) {
+      if (node->focused) return node;
+      for (int i = 0; i < node->nodes_size; ++i) {
+        const I3ipc_node* found = findFocused(&node->nodes[i]);
+        if (found) return found;
+      }
+      for (int i = 0; i < node->floating_nodes_size; ++i) {
+        const I3ipc_node* found = findFocused(&node->floating_nodes[i]);
+        if (found) return found;
+      }
+      return nullptr;
+    }
+
+    // Estado inicial: la ventana enfocada sale del árbol, una sola vez
+    void loadFocused() {
+      I3ipc_reply_tree* tree = i3ipc_get_tree();
+      if (!tree) {
+        showWindow(0);
+        return;
+      }
+
+      const I3ipc_node* focused = findFocused(&tree->root);
+      if (focused && focused->window_set) {
+        titles[focused->id] = focused->name ? focused->name : "";
+        showWindow(focused->id);
+      } else {
+        showWindow(0);
+      }
+    }
+};
+
+#endif // WINDOW_H
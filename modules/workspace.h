@@ -5,204 +5,270 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
-#include <sys/wait.h>
-#include <fcntl.h>
 #include <errno.h>
 #include <time.h>
 #include <vector>
 #include <string>
+#include <algorithm>
 
-#define I3IPC_IMPLEMENTATION
-#include "i3ipc.h"
+#include "i3_events.h"
 #include "module.h"
+#include "../log.h"
 
-class WorkspaceModule : public Module {
+#define MAX_WORKSPACES 32
+
+// Habla con i3 directo por el socket IPC (i3ipc.h): los eventos de workspace
+// llegan por I3EventHub y los comandos van por el socket de mensajes, sin
+// lanzar procesos.
+//
+// El módulo mantiene su propio modelo de workspaces indexado por el id de i3
+// y aplica los eventos con lo que trae el payload, leído con el parser en
+// streaming de i3ipc.h (sin tokens ni structs intermedios). Cada workspace ocupa un
+// slot fijo del pool con su BarElement; el orden en la barra es el orden de
+// los punteros en `elements` (por número y nombre, como lo ordena i3).
+class WorkspaceModule : public Module, public I3EventListener {
   public:
     WorkspaceModule() : Module("workspace", true, 1) {
-      initialize();
-      initializeElements();
-    }
-
-    ~WorkspaceModule() {
-      clearElements();
+      elements.reserve(MAX_WORKSPACES);
+      // Los handlers se arman una vez por slot y capturan solo el slot
+      for (int slot = 0; slot < MAX_WORKSPACES; ++slot) {
+        slotElements[slot].moduleName = name;
+        slotElements[slot].setEvent(BarElement::CLICK_LEFT, [this, slot]() {
+          switchToWorkspace(model[slot].name);
+        });
+      }
     }
 
     void update() {
-      updateElements();
+      resync();
     }
 
     bool initialize() {
-      i3Fd = subscribeI3();
-      return i3Fd != -1;
+      I3EventHub::instance().listen(this, I3IPC_EVENT_WORKSPACE);
+      resync();
+      // Sin i3 la barra sigue funcionando, solo sin workspaces
+      return true;
     }
 
-    int setupSelectFds(fd_set &fds) {
-      if (i3Fd != -1) {
-        FD_SET(i3Fd, &fds);
-        return i3Fd;
-      }
-      return -1;
+    void eventFds(std::vector<int> &fds) override {
+      int fd = I3EventHub::instance().fd();
+      if (fd != -1) fds.push_back(fd);
     }
 
-    bool handleI3Events(fd_set &fds);
+    // El hub pide el frame a la barra de cada listener que cambió
+    bool handleEvent(int fd) override {
+      I3EventHub::instance().dispatch();
+      return false;
+    }
+
+    void requestI3Render() override {
+      if (renderFunction) renderFunction();
+    }
+
+    bool onWorkspaceEvent(const I3ipc_event_workspace_view& ev) override {
+      bool changed = false;
+      if (!applyEvent(ev, changed)) needsResync = true;
+      return changed;
+    }
+
+    bool afterI3Events() override {
+      if (!needsResync) return false;
+      needsResync = false;
+      resync();
+      return true;
+    }
+
+    void onI3Reconnect() override {
+      resync();
+    }
 
   private:
-    int i3Fd;
-    std::vector<BarElement*> workspaceElements;
-
-    void initializeElements() {
-      clearElements();
-      
-      I3ipc_reply_workspaces* reply = i3ipc_get_workspaces();
-      if (!reply) return;
-
-      for (int i = 0; i < reply->workspaces_size; ++i) {
-        BarElement* element = new BarElement();
-        element->moduleName = name;
-        
-        // Copy workspace name with spaces
-        element->contentLen = snprintf(element->content, CONTENT_MAX_LEN - 1, 
-                                   " %s ", reply->workspaces[i].name);
-        element->content[element->contentLen] = '\0';
-        element->dirtyContent = true;
-        
-        // Set click event
-        std::string ws_name = reply->workspaces[i].name;
-        element->setEvent(BarElement::CLICK_LEFT, [this, ws_name]() {
-          switchToWorkspace(ws_name.c_str());
-        });
-        
-        // Set styling
-        if (reply->workspaces[i].focused) {
-          element->foregroundColor = Color::parse_color("#E0AAFF", NULL, Color(0xFF, 0xAA, 0xFF, 255));
-          element->underlineColor = Color::parse_color("#E0AAFF", NULL, Color(0xFF, 0xAA, 0xFF, 255));
-          element->underline = true;
-        } else {
-          element->foregroundColor = Color::parse_color("#666666", NULL, Color(0x66, 0x66, 0x66, 255));
-          element->underline = false;
-        }
-        
-        workspaceElements.push_back(element);
-        elements.push_back(element);
+    struct Workspace {
+      size_t id;
+      int num;                // -1 si el nombre no empieza con número
+      bool used;
+      bool focused;
+      bool urgent;
+      char name[CONTENT_MAX_LEN - 3];
+    };
+
+    bool needsResync = false;
+    // model[i] se dibuja en slotElements[i]; un slot libre tiene used = false
+    Workspace model[MAX_WORKSPACES] = {};
+    BarElement slotElements[MAX_WORKSPACES];
+
+    // Orden de i3: primero los numerados, por número, luego por nombre
+    static bool before(const Workspace& a, const Workspace& b) {
+      if (a.num != b.num) {
+        if (a.num < 0) return false;
+        if (b.num < 0) return true;
+        return a.num < b.num;
       }
-      
-      free(reply);
+      return strcmp(a.name, b.name) < 0;
     }
 
-    void clearElements() {
-      for (BarElement* element : workspaceElements) {
-        elements.erase(std::remove(elements.begin(), elements.end(), element), elements.end());
-        delete element;
+    Workspace* find(size_t id) {
+      for (Workspace& ws : model) {
+        if (ws.used && ws.id == id) return &ws;
       }
-      workspaceElements.clear();
-    }
-
-    void updateElements() {
-      I3ipc_reply_workspaces* reply = i3ipc_get_workspaces();
-      if (!reply) return;
-
-      // Update existing elements
-      for (size_t i = 0; i < workspaceElements.size() && i < (size_t)reply->workspaces_size; ++i) {
-        BarElement* element = workspaceElements[i];
-        
-        // Update content
-        element->contentLen = snprintf(element->content, CONTENT_MAX_LEN - 1, 
-                                   " %s ", reply->workspaces[i].name);
-        element->content[element->contentLen] = '\0';
-        element->dirtyContent = true;
-        
-        // Update styling
-        if (reply->workspaces[i].focused) {
-          element->foregroundColor = Color::parse_color("#E0AAFF", NULL, Color(0xFF, 0xAA, 0xFF, 255));
-          element->underlineColor = Color::parse_color("#E0AAFF", NULL, Color(0xFF, 0xAA, 0xFF, 255));
-          element->underline = true;
-        } else {
-          element->foregroundColor = Color::parse_color("#666666", NULL, Color(0x66, 0x66, 0x66, 255));
-          element->underline = false;
-        }
-      }
-      
-      // Handle workspace count changes
-      if ((size_t)reply->workspaces_size != workspaceElements.size()) {
-        initializeElements();
-      }
-      
-      free(reply);
+      return nullptr;
     }
 
-    void switchToWorkspace(const char* ws_name) {
-      // Execute workspace switch
-      if (fork() == 0) {
-        execlp("i3-msg", "i3-msg", "workspace", ws_name, NULL);
-        exit(1);
-      }
-      
-      // Trigger render
-      if (renderFunction) {
-        renderFunction();
-      }
+    BarElement* elementOf(const Workspace& ws) {
+      return &slotElements[&ws - model];
     }
 
-    int subscribeI3() {
-      int pipefd[2];
-      if (pipe(pipefd) == -1) return -1;
+    const Workspace& workspaceOf(const BarElement* element) {
+      return model[element - slotElements];
+    }
 
-      pid_t pid = fork();
-      if (pid == -1) {
-        close(pipefd[0]);
-        close(pipefd[1]);
-        return -1;
-      }
+    // Ubica el elemento según el orden; el resto de los elementos no se
+    // toca. elements tiene capacidad para todos los slots: no realoca.
+    void place(Workspace& ws) {
+      BarElement* element = elementOf(ws);
+      elements.erase(std::remove(elements.begin(), elements.end(), element), elements.end());
+      auto pos = elements.begin();
+      while (pos != elements.end() && before(workspaceOf(*pos), ws)) ++pos;
+      elements.insert(pos, element);
+    }
 
-      if (pid == 0) {
-        close(pipefd[0]);
-        dup2(pipefd[1], STDOUT_FILENO);
-        close(pipefd[1]);
-        execlp("i3-msg", "i3-msg", "-t", "subscribe", "[\"workspace\"]", NULL);
-        exit(1);
-      } else {
-        close(pipefd[1]);
-        int flags = fcntl(pipefd[0], F_GETFL, 0);
-        fcntl(pipefd[0], F_SETFL, flags | O_NONBLOCK);
-        return pipefd[0];
+    Workspace* add(const I3ipc_node_view& node) {
+      for (Workspace& ws : model) {
+        if (ws.used) continue;
+        ws.used = true;
+        ws.id = node.id;
+        ws.urgent = node.urgent;
+        setName(ws, node);
+        setFocused(ws, node.focused);
+        place(ws);
+        return &ws;
       }
+      LOG_WARN("[workspace] More than %d workspaces, ignoring '%s'", MAX_WORKSPACES, node.name.str);
+      return nullptr;
     }
 
-    bool isWorkspaceEvent(const char* json_data) {
-      return strstr(json_data, "\"change\":\"focus\"") ||
-             strstr(json_data, "\"change\":\"init\"") ||
-             strstr(json_data, "\"change\":\"empty\"") ||
-             strstr(json_data, "\"change\":\"urgent\"");
+    void remove(Workspace& ws) {
+      ws.used = false;
+      BarElement* element = elementOf(ws);
+      elements.erase(std::remove(elements.begin(), elements.end(), element), elements.end());
+    }
+
+    void setName(Workspace& ws, const I3ipc_node_view& node) {
+      int len = snprintf(ws.name, sizeof(ws.name), "%s", node.name.str ? node.name.str : "");
+      if (len >= (int)sizeof(ws.name))
+        ws.name[utf8Truncate(ws.name, sizeof(ws.name) - 1)] = '\0';
+      ws.num = node.num;
+      BarElement* element = elementOf(ws);
+      element->contentLen = snprintf(element->content, CONTENT_MAX_LEN - 1, " %s ", ws.name);
+      element->content[element->contentLen] = '\0';
+      element->dirtyContent = true;
     }
-};
 
-inline bool WorkspaceModule::handleI3Events(fd_set &fds) {
-  bool workspace_changed = false;
-
-  if (i3Fd != -1 && FD_ISSET(i3Fd, &fds)) {
-    char buffer[4096];
-    ssize_t bytes_read;
-    
-    while ((bytes_read = read(i3Fd, buffer, sizeof(buffer) - 1)) > 0) {
-      buffer[bytes_read] = '\0';
-      
-      if (isWorkspaceEvent(buffer)) {
-        workspace_changed = true;
-        break;
+    void setFocused(Workspace& ws, bool focused) {
+      ws.focused = focused;
+      BarElement* element = elementOf(ws);
+      if (focused) {
+        element->foregroundColor = Color::parse_color("#E0AAFF", NULL, Color(0xFF, 0xAA, 0xFF, 255));
+        element->underlineColor = Color::parse_color("#E0AAFF", NULL, Color(0xFF, 0xAA, 0xFF, 255));
+        element->underline = true;
+      } else {
+        element->foregroundColor = Color::parse_color("#666666", NULL, Color(0x66, 0x66, 0x66, 255));
+        element->underline = false;
       }
     }
 
-    if (bytes_read == 0) {
-      close(i3Fd);
-      i3Fd = subscribeI3();
+    // Relee la lista completa. Solo al arrancar, al reconectar y para
+    // eventos que no traen lo necesario (reload, restored, ids desconocidos).
+    void resync() {
+      for (Workspace& ws : model) {
+        if (ws.used) remove(ws);
+      }
+
+      i3ipc_get_workspaces_stream_try([](I3ipc_node_view const* node, void* user) {
+        ((WorkspaceModule*)user)->add(*node);
+      }, this);
     }
 
-    if (workspace_changed) {
-      updateElements();
+    // Aplica el evento sobre el modelo. changed indica si algo visible
+    // cambió; false si el payload no alcanza y hay que releer la lista.
+    bool applyEvent(const I3ipc_event_workspace_view& ev, bool& changed) {
+      const I3ipc_node_view& current = ev.current;
+      Workspace* ws = current.set ? find(current.id) : nullptr;
+
+      switch (ev.change_enum) {
+        case I3IPC_WORKSPACE_CHANGE_FOCUS: {
+          if (!ws) return false;
+          Workspace* old = ev.old.set ? find(ev.old.id) : nullptr;
+          if (old && old != ws && old->focused) {
+            setFocused(*old, false);
+            changed = true;
+          }
+          if (!ws->focused) {
+            // Por las dudas: un solo workspace enfocado
+            for (Workspace& other : model) {
+              if (other.used && other.focused) setFocused(other, false);
+            }
+            setFocused(*ws, true);
+            changed = true;
+          }
+          return true;
+        }
+
+        case I3IPC_WORKSPACE_CHANGE_INIT:
+          if (!current.set || !current.name.str) return false;
+          if (!ws) {
+            add(current);
+            changed = true;
+          }
+          return true;
+
+        case I3IPC_WORKSPACE_CHANGE_EMPTY:
+          if (ws) {
+            remove(*ws);
+            changed = true;
+          }
+          return true;
+
+        case I3IPC_WORKSPACE_CHANGE_RENAME:
+          if (!ws || !current.name.str) return false;
+          setName(*ws, current);
+          place(*ws);
+          changed = true;
+          return true;
+
+        case I3IPC_WORKSPACE_CHANGE_URGENT:
+          // El estilo no distingue urgentes: se guarda pero no hay cambio visible
+          if (!ws) return false;
+          ws->urgent = current.urgent;
+          return true;
+
+        case I3IPC_WORKSPACE_CHANGE_MOVE:
+          // Cambió de output; el orden de la barra no depende del output
+          return ws != nullptr;
+
+        default:
+          // reload, restored
+          return false;
+      }
     }
-  }
 
-  return workspace_changed;
-}
+    void switchToWorkspace(const char* ws_name) {
+      // workspace "<nombre>" con las comillas del nombre escapadas
+      char command[sizeof(model[0].name) * 2 + 16];
+      char* p = command + sprintf(command, "workspace \"");
+      for (const char* c = ws_name; *c; ++c) {
+        if (*c == '"' || *c == '\\') *p++ = '\\';
+        *p++ = *c;
+      }
+      *p++ = '"';
+      *p = '\0';
+
+      // El cambio de foco vuelve como evento y redibuja la barra
+      if (!i3ipc_run_command(command)) {
+        i3ipc_error_print("[workspace] run_command");
+        I3EventHub::instance().reconnect();
+      }
+    }
+};
 
-#endif // WORKSPACE_H
\ No newline at end of file
+#endif // WORKSPACE_H
@@ -0,0 +1,302 @@
+// vim:sw=4:ts=4:et:
+#ifndef SHM_BACKEND_H
+#define SHM_BACKEND_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <vector>
+#include <unordered_map>
+
+#include <xcb/xcb.h>
+#include <xcb/shm.h>
+#include <X11/Xft/Xft.h>
+
+#include "log.h"
+
+// Coberturas A8 de los glifos ya rasterizados, por fuente. No depende de
+// ninguna superficie, así que la comparten todas las barras.
+class ShmGlyphCache {
+public:
+    struct Glyph {
+        uint16_t width, height;
+        int16_t left, top;
+        std::vector<uint8_t> coverage;
+    };
+
+    // Rasteriza ch una sola vez y guarda su cobertura A8. Devuelve las
+    // métricas con la misma convención que XftGlyphExtents.
+    bool loadGlyph(int fontSlot, XftFont *font, uint32_t ch, XGlyphInfo *gi) {
+        memset(gi, 0, sizeof(*gi));
+
+        FT_Face face = XftLockFace(font);
+        if (!face)
+            return false;
+
+        FT_UInt index = FT_Get_Char_Index(face, ch);
+        if (FT_Load_Glyph(face, index, FT_LOAD_RENDER | FT_LOAD_TARGET_NORMAL)) {
+            XftUnlockFace(font);
+            return false;
+        }
+
+        FT_GlyphSlot slot = face->glyph;
+        const FT_Bitmap &bm = slot->bitmap;
+
+        gi->width = bm.width;
+        gi->height = bm.rows;
+        gi->x = -slot->bitmap_left;
+        gi->y = slot->bitmap_top;
+        gi->xOff = (slot->advance.x + 32) >> 6;
+        gi->yOff = 0;
+
+        Glyph &g = glyphsFor(fontSlot)[ch];
+        g.width = bm.width;
+        g.height = bm.rows;
+        g.left = slot->bitmap_left;
+        g.top = slot->bitmap_top;
+        g.coverage.assign(bm.width * bm.rows, 0);
+        for (unsigned int row = 0; row < bm.rows; row++) {
+            const uint8_t *src = bm.buffer + row * bm.pitch;
+            uint8_t *dst = g.coverage.data() + row * bm.width;
+            if (bm.pixel_mode == FT_PIXEL_MODE_MONO) {
+                for (unsigned int col = 0; col < bm.width; col++)
+                    dst[col] = (src[col >> 3] & (0x80 >> (col & 7))) ? 0xff : 0;
+            } else {
+                memcpy(dst, src, bm.width);
+            }
+        }
+        XftUnlockFace(font);
+        return true;
+    }
+
+    const Glyph *find(int fontSlot, uint32_t ch) {
+        std::unordered_map<uint32_t, Glyph> &glyphs = glyphsFor(fontSlot);
+        auto it = glyphs.find(ch);
+        return it != glyphs.end() ? &it->second : nullptr;
+    }
+
+    void clear(void) {
+        glyphsets.clear();
+    }
+
+private:
+    std::vector<std::unordered_map<uint32_t, Glyph>> glyphsets; // por fuente
+
+    std::unordered_map<uint32_t, Glyph>& glyphsFor(int fontSlot) {
+        if ((int)glyphsets.size() <= fontSlot)
+            glyphsets.resize(fontSlot + 1);
+        return glyphsets[fontSlot];
+    }
+};
+
+// Backend de rasterizado en el cliente. La barra entera vive en un buffer
+// ARGB (premultiplicado, mismo formato que Color::v) compartido con el
+// servidor vía MIT-SHM. Rectángulos y glifos se pintan en memoria y cada
+// frame se presenta con un único xcb_shm_put_image sobre el pixmap.
+class ShmSurface {
+public:
+    bool init(xcb_connection_t *conn, ShmGlyphCache *glyphCache) {
+        c = conn;
+        glyphs = glyphCache;
+
+        xcb_shm_query_version_reply_t *ver = xcb_shm_query_version_reply(c,
+            xcb_shm_query_version(c), NULL);
+        if (!ver) {
+            LOG_WARN("[shm] MIT-SHM extension not available");
+            return false;
+        }
+        free(ver);
+
+        const xcb_query_extension_reply_t *ext = xcb_get_extension_data(c, &xcb_shm_id);
+        completionEvent = ext ? ext->first_event + XCB_SHM_COMPLETION : 0;
+        return true;
+    }
+
+    // (Re)crea el segmento compartido con el tamaño de la barra
+    bool resize(int w, int h) {
+        release();
+
+        size_t bytes = (size_t)w * h * 4;
+        shmId = shmget(IPC_PRIVATE, bytes, IPC_CREAT | 0600);
+        if (shmId < 0) {
+            LOG_WARN("[shm] shmget: %s", strerror(errno));
+            return false;
+        }
+
+        void *addr = shmat(shmId, NULL, 0);
+        if (addr == (void *)-1) {
+            LOG_WARN("[shm] shmat: %s", strerror(errno));
+            shmctl(shmId, IPC_RMID, NULL);
+            shmId = -1;
+            return false;
+        }
+
+        seg = xcb_generate_id(c);
+        xcb_generic_error_t *err = xcb_request_check(c, xcb_shm_attach_checked(c, seg, shmId, 0));
+        // Se marca para borrar ya: desaparece cuando el cliente y el
+        // servidor se desconecten, aunque el proceso muera de golpe
+        shmctl(shmId, IPC_RMID, NULL);
+        if (err) {
+            LOG_WARN("[shm] xcb_shm_attach failed (error %d)", err->error_code);
+            free(err);
+            shmdt(addr);
+            shmId = -1;
+            seg = 0;
+            return false;
+        }
+
+        pixels = (uint32_t *)addr;
+        width = w;
+        height = h;
+        return true;
+    }
+
+    void fillRect(int x, int y, int w, int h, uint32_t argb) {
+        if (!clip(x, w, width) || !clip(y, h, height))
+            return;
+        waitPresent();
+        for (int row = y; row < y + h; row++) {
+            uint32_t *dst = pixels + row * width + x;
+            for (int i = 0; i < w; i++)
+                dst[i] = argb;
+        }
+    }
+
+    // Mezcla un run de glifos sobre el buffer. Las posiciones salen de los
+    // anchos que ya midió la barra. Un glifo que midió otra barra del mismo
+    // display con otro backend no está en el cache: se carga acá.
+    void drawGlyphs(int fontSlot, XftFont *font, int x, int y, const uint32_t *ucs,
+                    const uint8_t *widths, int len, uint32_t argb) {
+        waitPresent();
+        for (int i = 0; i < len; x += widths[i], i++) {
+            const ShmGlyphCache::Glyph *g = glyphs->find(fontSlot, ucs[i]);
+            if (!g) {
+                XGlyphInfo gi;
+                if (glyphs->loadGlyph(fontSlot, font, ucs[i], &gi))
+                    g = glyphs->find(fontSlot, ucs[i]);
+            }
+            if (g)
+                blendGlyph(*g, x, y, argb);
+        }
+    }
+
+    // Copia el tramo [x0, x1) del buffer al drawable. El servidor avisa con
+    // un ShmCompletion al terminar de leer el segmento; hasta entonces el
+    // buffer no se vuelve a tocar (ver waitPresent).
+    void present(xcb_drawable_t d, xcb_gcontext_t gc, uint8_t depth, int x0, int x1) {
+        if (!clip(x0, x1 -= x0, width))
+            return;
+        waitPresent();
+        pendingPut = xcb_shm_put_image(c, d, gc, width, height,
+                                       x0, 0, x1, height, x0, 0,
+                                       depth, XCB_IMAGE_FORMAT_Z_PIXMAP, 1, seg, 0);
+        presentPending = true;
+    }
+
+    // Lo llama el loop de eventos de X. true si ev era el aviso del último
+    // put de esta superficie; uno viejo (de un put ya esperado) se ignora.
+    bool handleCompletion(const xcb_generic_event_t *ev) {
+        if (!completionEvent || (ev->response_type & 0x7F) != completionEvent)
+            return false;
+        const xcb_shm_completion_event_t *done = (const xcb_shm_completion_event_t *)ev;
+        if (done->shmseg != seg)
+            return false;
+        if (presentPending && done->sequence == (uint16_t)pendingPut.sequence)
+            presentPending = false;
+        return true;
+    }
+
+    bool valid(void) const {
+        return pixels != nullptr;
+    }
+
+    void cleanup(void) {
+        release();
+    }
+
+private:
+    xcb_connection_t *c = nullptr;
+    ShmGlyphCache *glyphs = nullptr;
+    xcb_shm_seg_t seg = 0;
+    int shmId = -1;
+    uint32_t *pixels = nullptr;
+    int width = 0, height = 0;
+
+    xcb_void_cookie_t pendingPut;
+    bool presentPending = false;
+    uint8_t completionEvent = 0;
+
+    // Recorta [pos, pos + len) a [0, limit); false si queda vacío
+    static bool clip(int &pos, int &len, int limit) {
+        if (pos < 0) {
+            len += pos;
+            pos = 0;
+        }
+        if (pos + len > limit)
+            len = limit - pos;
+        return len > 0;
+    }
+
+    // El servidor lee el segmento de forma asíncrona: antes de escribirlo de
+    // nuevo hay que saber que terminó con el put anterior. Lo normal es que
+    // el ShmCompletion ya haya llegado entre frames; si no (un frame justo
+    // después del otro), un round trip alcanza, porque el servidor lee el
+    // segmento mientras procesa el put.
+    void waitPresent(void) {
+        if (!presentPending)
+            return;
+        presentPending = false;
+        free(xcb_get_input_focus_reply(c, xcb_get_input_focus(c), NULL));
+    }
+
+    // OVER con la cobertura del glifo como máscara, en premultiplicado
+    void blendGlyph(const ShmGlyphCache::Glyph &g, int x, int y, uint32_t argb) {
+        int gx = x + g.left;
+        int gy = y - g.top;
+        int x0 = gx < 0 ? -gx : 0;
+        int y0 = gy < 0 ? -gy : 0;
+        int x1 = (gx + g.width > width) ? width - gx : g.width;
+        int y1 = (gy + g.height > height) ? height - gy : g.height;
+
+        for (int row = y0; row < y1; row++) {
+            const uint8_t *cov = g.coverage.data() + row * g.width;
+            uint32_t *dst = pixels + (gy + row) * width + gx;
+            for (int col = x0; col < x1; col++) {
+                uint32_t m = cov[col];
+                if (!m)
+                    continue;
+                if (m == 0xff && (argb >> 24) == 0xff) {
+                    dst[col] = argb;
+                    continue;
+                }
+                uint32_t s = argb, d = dst[col], out = 0;
+                uint32_t sa = ((s >> 24) * m + 127) / 255;
+                for (int shift = 0; shift < 32; shift += 8) {
+                    uint32_t sc = (((s >> shift) & 0xff) * m + 127) / 255;
+                    uint32_t dc = (d >> shift) & 0xff;
+                    out |= (sc + (dc * (255 - sa) + 127) / 255) << shift;
+                }
+                dst[col] = out;
+            }
+        }
+    }
+
+    void release(void) {
+        waitPresent();
+        if (seg) {
+            xcb_shm_detach(c, seg);
+            seg = 0;
+        }
+        if (pixels) {
+            shmdt(pixels);
+            pixels = nullptr;
+        }
+        shmId = -1;
+        width = height = 0;
+    }
+};
+
+#endif // SHM_BACKEND_H
@@ -0,0 +1,449 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "log.h"
+
+// Instrumentación siempre encendida. Los contadores son atómicos relajados:
+// los escribe el hilo de render o un worker sin locks y los lee el volcado
+// (socket de stats o SIGUSR1) cuando alguien pregunta.
+
+// Histograma de latencias en buckets de potencias de 2 de microsegundos:
+// el bucket 0 es < 1us, el i cubre [2^(i-1), 2^i) us y el último todo lo demás.
+struct LatencyHistogram {
+    static const int BUCKETS = 22;
+
+    std::atomic<uint64_t> buckets[BUCKETS];
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> totalNs;
+    std::atomic<uint64_t> maxNs;
+
+    LatencyHistogram() : count(0), totalNs(0), maxNs(0) {
+        for (int i = 0; i < BUCKETS; i++)
+            buckets[i].store(0, std::memory_order_relaxed);
+    }
+
+    void record(int64_t ns) {
+        if (ns < 0) ns = 0;
+        uint64_t us = (uint64_t)ns / 1000;
+        int bucket = 0;
+        while (us && bucket < BUCKETS - 1) {
+            us >>= 1;
+            bucket++;
+        }
+        buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+        count.fetch_add(1, std::memory_order_relaxed);
+        totalNs.fetch_add(ns, std::memory_order_relaxed);
+
+        uint64_t seen = maxNs.load(std::memory_order_relaxed);
+        while ((uint64_t)ns > seen &&
+               !maxNs.compare_exchange_weak(seen, ns, std::memory_order_relaxed)) {
+        }
+    }
+
+    // Cota superior (en us) del bucket donde cae el percentil p, sin pasar
+    // del máximo visto
+    uint64_t percentileUs(double p) const {
+        uint64_t n = count.load(std::memory_order_relaxed);
+        if (!n) return 0;
+        uint64_t target = (uint64_t)(n * p);
+        if (target >= n) target = n - 1;
+        uint64_t maxUs = (maxNs.load(std::memory_order_relaxed) + 999) / 1000;
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKETS; i++) {
+            seen += buckets[i].load(std::memory_order_relaxed);
+            if (seen > target) return std::min((uint64_t)1 << i, maxUs);
+        }
+        return maxUs;
+    }
+
+    uint64_t averageUs() const {
+        uint64_t n = count.load(std::memory_order_relaxed);
+        return n ? totalNs.load(std::memory_order_relaxed) / n / 1000 : 0;
+    }
+};
+
+// Un módulo de una barra ("topBar/audio"): update() por deadline o en el
+// pool, y handleEvent() por sus fds
+struct ModuleStats {
+    std::string name;
+    LatencyHistogram updates;
+    LatencyHistogram events;
+
+    explicit ModuleStats(const std::string& name) : name(name) {}
+};
+
+// Frames de una barra. Los caches se publican al final de cada frame.
+struct BarStats {
+    std::string name;
+    LatencyHistogram layout;      // parseo y layout de los elementos
+    LatencyHistogram raster;      // dibujar los elementos dañados
+    LatencyHistogram present;     // llevar el frame a las ventanas
+
+    std::atomic<uint64_t> frames;
+    std::atomic<uint64_t> framesSkipped;     // feed() sin nada dañado
+    std::atomic<uint64_t> renderCoalesced;   // pedidos que cayeron en uno pendiente
+    std::atomic<uint64_t> framesDeferred;    // frames postergados por --max-fps
+    std::atomic<uint64_t> renderCacheHits;
+    std::atomic<uint64_t> renderCacheMisses;
+
+    explicit BarStats(const std::string& name) :
+        name(name), frames(0), framesSkipped(0), renderCoalesced(0),
+        framesDeferred(0), renderCacheHits(0), renderCacheMisses(0) {}
+};
+
+class Stats {
+public:
+    static Stats& instance() {
+        static Stats stats;
+        return stats;
+    }
+
+    static int64_t nowNs() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+    }
+
+    // Registro: una vez por módulo/barra al arrancar. Los punteros valen
+    // todo el proceso (deque no mueve lo que ya tiene).
+    ModuleStats* module(const std::string& name) {
+        std::lock_guard<std::mutex> lock(mutex);
+        modules.emplace_back(name);
+        return &modules.back();
+    }
+
+    BarStats* bar(const std::string& name) {
+        std::lock_guard<std::mutex> lock(mutex);
+        bars.emplace_back(name);
+        return &bars.back();
+    }
+
+    // Compartidos por todas las barras (fuentes y conexión son una sola)
+    std::atomic<uint64_t> glyphHits;
+    std::atomic<uint64_t> glyphMisses;
+    std::atomic<uint64_t> xRequests;
+
+    std::string text() {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::string out;
+        char line[256];
+
+        snprintf(line, sizeof(line), "photonbar stats, uptime %llds\n",
+                 (long long)((nowNs() - startNs) / 1000000000));
+        out += line;
+
+        uint64_t frames = 0;
+        for (BarStats& bar : bars) {
+            uint64_t n = bar.frames.load(std::memory_order_relaxed);
+            frames += n;
+            snprintf(line, sizeof(line),
+                     "\nbar %s: %llu frames, %llu skipped, %llu coalesced, %llu deferred\n",
+                     bar.name.c_str(), (unsigned long long)n,
+                     (unsigned long long)bar.framesSkipped.load(std::memory_order_relaxed),
+                     (unsigned long long)bar.renderCoalesced.load(std::memory_order_relaxed),
+                     (unsigned long long)bar.framesDeferred.load(std::memory_order_relaxed));
+            out += line;
+            out += "  phase        avg us   p50 us   p99 us   max us\n";
+            textHistogram(out, "  layout ", bar.layout);
+            textHistogram(out, "  raster ", bar.raster);
+            textHistogram(out, "  present", bar.present);
+            textRate(out, "  render cache", bar.renderCacheHits, bar.renderCacheMisses);
+        }
+
+        out += "\n";
+        textRate(out, "glyph cache", glyphHits, glyphMisses);
+        uint64_t requests = xRequests.load(std::memory_order_relaxed);
+        snprintf(line, sizeof(line), "x requests: %llu (%.1f/frame)\n",
+                 (unsigned long long)requests, frames ? (double)requests / frames : 0.0);
+        out += line;
+
+        // Primero el que más CPU se llevó
+        std::vector<const ModuleStats*> sorted = sortedModules();
+        out += "\nmodule                      updates   avg us   p99 us   max us  events   avg us   total ms\n";
+        for (const ModuleStats* m : sorted) {
+            snprintf(line, sizeof(line),
+                     "%-26s %8llu %8llu %8llu %8llu %7llu %8llu %10.1f\n",
+                     m->name.c_str(),
+                     (unsigned long long)m->updates.count.load(std::memory_order_relaxed),
+                     (unsigned long long)m->updates.averageUs(),
+                     (unsigned long long)m->updates.percentileUs(0.99),
+                     (unsigned long long)(m->updates.maxNs.load(std::memory_order_relaxed) / 1000),
+                     (unsigned long long)m->events.count.load(std::memory_order_relaxed),
+                     (unsigned long long)m->events.averageUs(),
+                     totalNs(m) / 1e6);
+            out += line;
+        }
+        return out;
+    }
+
+    std::string json() {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::string out;
+        char buf[256];
+
+        snprintf(buf, sizeof(buf), "{\"uptime_s\":%lld,\"bars\":[",
+                 (long long)((nowNs() - startNs) / 1000000000));
+        out += buf;
+        for (size_t i = 0; i < bars.size(); i++) {
+            BarStats& bar = bars[i];
+            if (i) out += ",";
+            out += "{\"name\":";
+            jsonString(out, bar.name);
+            snprintf(buf, sizeof(buf),
+                     ",\"frames\":%llu,\"skipped\":%llu,\"coalesced\":%llu,\"deferred\":%llu,"
+                     "\"render_cache\":{\"hits\":%llu,\"misses\":%llu}",
+                     (unsigned long long)bar.frames.load(std::memory_order_relaxed),
+                     (unsigned long long)bar.framesSkipped.load(std::memory_order_relaxed),
+                     (unsigned long long)bar.renderCoalesced.load(std::memory_order_relaxed),
+                     (unsigned long long)bar.framesDeferred.load(std::memory_order_relaxed),
+                     (unsigned long long)bar.renderCacheHits.load(std::memory_order_relaxed),
+                     (unsigned long long)bar.renderCacheMisses.load(std::memory_order_relaxed));
+            out += buf;
+            jsonHistogram(out, "layout", bar.layout);
+            jsonHistogram(out, "raster", bar.raster);
+            jsonHistogram(out, "present", bar.present);
+            out += "}";
+        }
+
+        snprintf(buf, sizeof(buf),
+                 "],\"glyph_cache\":{\"hits\":%llu,\"misses\":%llu},\"x_requests\":%llu,\"modules\":[",
+                 (unsigned long long)glyphHits.load(std::memory_order_relaxed),
+                 (unsigned long long)glyphMisses.load(std::memory_order_relaxed),
+                 (unsigned long long)xRequests.load(std::memory_order_relaxed));
+        out += buf;
+
+        std::vector<const ModuleStats*> sorted = sortedModules();
+        for (size_t i = 0; i < sorted.size(); i++) {
+            if (i) out += ",";
+            out += "{\"name\":";
+            jsonString(out, sorted[i]->name);
+            jsonHistogram(out, "update", sorted[i]->updates);
+            jsonHistogram(out, "event", sorted[i]->events);
+            out += "}";
+        }
+        out += "]}\n";
+        return out;
+    }
+
+private:
+    Stats() : glyphHits(0), glyphMisses(0), xRequests(0), startNs(nowNs()) {}
+
+    std::mutex mutex;                 // solo registro y volcado
+    std::deque<ModuleStats> modules;
+    std::deque<BarStats> bars;
+    int64_t startNs;
+
+    static uint64_t totalNs(const ModuleStats* m) {
+        return m->updates.totalNs.load(std::memory_order_relaxed) +
+               m->events.totalNs.load(std::memory_order_relaxed);
+    }
+
+    std::vector<const ModuleStats*> sortedModules() {
+        std::vector<const ModuleStats*> sorted;
+        for (const ModuleStats& m : modules)
+            sorted.push_back(&m);
+        std::sort(sorted.begin(), sorted.end(), [](const ModuleStats* a, const ModuleStats* b) {
+            return totalNs(a) > totalNs(b);
+        });
+        return sorted;
+    }
+
+    static void textHistogram(std::string& out, const char* label, const LatencyHistogram& h) {
+        char line[128];
+        snprintf(line, sizeof(line), "%s   %8llu %8llu %8llu %8llu\n", label,
+                 (unsigned long long)h.averageUs(),
+                 (unsigned long long)h.percentileUs(0.5),
+                 (unsigned long long)h.percentileUs(0.99),
+                 (unsigned long long)(h.maxNs.load(std::memory_order_relaxed) / 1000));
+        out += line;
+    }
+
+    static void textRate(std::string& out, const char* label,
+                         const std::atomic<uint64_t>& hits, const std::atomic<uint64_t>& misses) {
+        uint64_t h = hits.load(std::memory_order_relaxed);
+        uint64_t m = misses.load(std::memory_order_relaxed);
+        char line[128];
+        snprintf(line, sizeof(line), "%s: %llu hits, %llu misses (%.1f%%)\n", label,
+                 (unsigned long long)h, (unsigned long long)m,
+                 h + m ? 100.0 * h / (h + m) : 0.0);
+        out += line;
+    }
+
+    static void jsonHistogram(std::string& out, const char* key, const LatencyHistogram& h) {
+        char buf[256];
+        snprintf(buf, sizeof(buf),
+                 ",\"%s\":{\"count\":%llu,\"total_ns\":%llu,\"max_ns\":%llu,\"p50_us\":%llu,\"p99_us\":%llu,\"buckets_us\":[",
+                 key,
+                 (unsigned long long)h.count.load(std::memory_order_relaxed),
+                 (unsigned long long)h.totalNs.load(std::memory_order_relaxed),
+                 (unsigned long long)h.maxNs.load(std::memory_order_relaxed),
+                 (unsigned long long)h.percentileUs(0.5),
+                 (unsigned long long)h.percentileUs(0.99));
+        out += buf;
+        for (int i = 0; i < LatencyHistogram::BUCKETS; i++) {
+            snprintf(buf, sizeof(buf), i ? ",%llu" : "%llu",
+                     (unsigned long long)h.buckets[i].load(std::memory_order_relaxed));
+            out += buf;
+        }
+        out += "]}";
+    }
+
+    static void jsonString(std::string& out, const std::string& s) {
+        out += '"';
+        for (char ch : s) {
+            if (ch == '"' || ch == '\\') out += '\\';
+            if ((unsigned char)ch >= 0x20) out += ch;
+        }
+        out += '"';
+    }
+};
+
+// Mide el bloque en el que vive
+class StatsTimer {
+public:
+    explicit StatsTimer(LatencyHistogram& histogram) :
+        histogram(histogram), start(Stats::nowNs()) {}
+    ~StatsTimer() { histogram.record(Stats::nowNs() - start); }
+
+private:
+    LatencyHistogram& histogram;
+    int64_t start;
+};
+
+// Endpoint de las stats: un socket UNIX en $XDG_RUNTIME_DIR/photonbar.sock
+// (o /tmp/photonbar-<uid>.sock) y SIGUSR1 por signalfd, que vuelca el texto
+// a stderr. El cliente manda "json" o "text" (o nada y cierra su lado):
+//
+//   echo json | nc -U $XDG_RUNTIME_DIR/photonbar.sock
+//   kill -USR1 $(pidof photonbar)
+//
+// Sus fds van en el epoll del loop; todo corre en el hilo de render.
+class StatsServer {
+public:
+    ~StatsServer() {
+        for (int fd : clients) close(fd);
+        if (listenFd != -1) {
+            close(listenFd);
+            unlink(path.c_str());
+        }
+        if (signalFd != -1) close(signalFd);
+    }
+
+    // SIGUSR1 se atiende por signalfd: hay que bloquearlo antes de crear
+    // cualquier hilo, si no el kernel se la puede entregar a un worker
+    static void blockSignal() {
+        sigset_t mask;
+        sigemptyset(&mask);
+        sigaddset(&mask, SIGUSR1);
+        pthread_sigmask(SIG_BLOCK, &mask, NULL);
+    }
+
+    bool start() {
+        sigset_t mask;
+        sigemptyset(&mask);
+        sigaddset(&mask, SIGUSR1);
+        signalFd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+        if (signalFd == -1)
+            LOG_WARN("[stats] signalfd: %s", strerror(errno));
+
+        const char* runtime = getenv("XDG_RUNTIME_DIR");
+        if (runtime && *runtime) {
+            path = std::string(runtime) + "/photonbar.sock";
+        } else {
+            path = "/tmp/photonbar-" + std::to_string(getuid()) + ".sock";
+        }
+
+        struct sockaddr_un addr = {};
+        addr.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(addr.sun_path)) {
+            LOG_WARN("[stats] socket path too long: %s", path.c_str());
+            return signalFd != -1;
+        }
+        memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+
+        listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listenFd == -1) {
+            LOG_WARN("[stats] socket: %s", strerror(errno));
+            return signalFd != -1;
+        }
+        // ProcessManager ya garantiza una sola instancia: un socket que
+        // quedó es de una corrida anterior
+        unlink(path.c_str());
+        if (bind(listenFd, (struct sockaddr*)&addr, sizeof(addr)) == -1 ||
+            listen(listenFd, 4) == -1) {
+            LOG_WARN("[stats] %s: %s", path.c_str(), strerror(errno));
+            close(listenFd);
+            listenFd = -1;
+        }
+        return listenFd != -1 || signalFd != -1;
+    }
+
+    int listenSocket() const { return listenFd; }
+    int signalSocket() const { return signalFd; }
+
+    bool owns(int fd) const {
+        return fd != -1 && (fd == listenFd || fd == signalFd ||
+                            std::find(clients.begin(), clients.end(), fd) != clients.end());
+    }
+
+    // Atiende un fd propio. Devuelve un cliente recién aceptado que hay que
+    // vigilar, o -1. Un cliente atendido se cierra (y sale solo del epoll).
+    int handleFd(int fd) {
+        if (fd == signalFd) {
+            struct signalfd_siginfo info;
+            while (read(signalFd, &info, sizeof(info)) == sizeof(info)) {
+            }
+            std::string out = Stats::instance().text();
+            fputs(out.c_str(), stderr);
+            return -1;
+        }
+
+        if (fd == listenFd) {
+            int client = accept4(listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (client == -1)
+                return -1;
+            clients.push_back(client);
+            return client;
+        }
+
+        char request[64];
+        ssize_t n = recv(fd, request, sizeof(request) - 1, 0);
+        if (n < 0 && errno == EAGAIN)
+            return -1;
+        request[n > 0 ? n : 0] = '\0';
+
+        std::string out = strstr(request, "json") ? Stats::instance().json()
+                                                  : Stats::instance().text();
+        // El volcado entra en el buffer del socket; si el cliente no lee, se corta
+        send(fd, out.data(), out.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+        clients.erase(std::find(clients.begin(), clients.end(), fd));
+        close(fd);
+        return -1;
+    }
+
+private:
+    std::string path;
+    int listenFd = -1;
+    int signalFd = -1;
+    std::vector<int> clients;
+};
+
+#endif
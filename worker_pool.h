@@ -0,0 +1,120 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+#include "log.h"
+
+// Pool chico de hilos para los updates que bloquean (red, subprocesos).
+// El trabajo corre fuera del hilo de render; la parte "done" de cada trabajo
+// vuelve al hilo de render a través de un eventfd y se ejecuta en collect().
+class WorkerPool {
+public:
+    explicit WorkerPool(int threadCount) {
+        notifyFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (notifyFd == -1) {
+            LOG_ERROR("[WorkerPool] eventfd: %s", strerror(errno));
+        }
+        for (int i = 0; i < threadCount; i++) {
+            threads.emplace_back([this]() { workerLoop(); });
+        }
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        cv.notify_all();
+        for (std::thread& t : threads) {
+            t.join();
+        }
+        if (notifyFd != -1) close(notifyFd);
+    }
+
+    // Se vuelve legible cuando hay trabajos terminados
+    int eventFd() const {
+        return notifyFd;
+    }
+
+    void submit(std::function<void()> work, std::function<bool()> done) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending.push_back({std::move(work), std::move(done)});
+        }
+        cv.notify_one();
+    }
+
+    // Solo desde el hilo de render. Corre los done de los trabajos
+    // terminados; true si alguno reporta un cambio visible.
+    bool collect() {
+        uint64_t count;
+        if (read(notifyFd, &count, sizeof(count)) < 0 && errno != EAGAIN) {
+            LOG_WARN("[WorkerPool] eventfd read: %s", strerror(errno));
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ready.swap(completed);
+        }
+
+        bool changed = false;
+        for (Job& job : ready) {
+            if (job.done && job.done()) changed = true;
+        }
+        ready.clear();
+        return changed;
+    }
+
+private:
+    struct Job {
+        std::function<void()> work;
+        std::function<bool()> done;
+    };
+
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<Job> pending;
+    std::deque<Job> completed;
+    std::deque<Job> ready;      // lo usa solo collect(), evita realocar
+    bool stopping = false;
+    int notifyFd = -1;
+
+    void workerLoop() {
+        while (true) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [this]() { return stopping || !pending.empty(); });
+                if (stopping) return;
+                job = std::move(pending.front());
+                pending.pop_front();
+            }
+
+            job.work();
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                completed.push_back(std::move(job));
+            }
+            uint64_t one = 1;
+            if (write(notifyFd, &one, sizeof(one)) < 0) {
+                LOG_WARN("[WorkerPool] eventfd write: %s", strerror(errno));
+            }
+        }
+    }
+};
+
+#endif
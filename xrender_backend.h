@@ -0,0 +1,227 @@
+// vim:sw=4:ts=4:et:
+#ifndef XRENDER_BACKEND_H
+#define XRENDER_BACKEND_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <unordered_map>
+
+#include <xcb/xcb.h>
+#include <xcb/render.h>
+#include <X11/Xft/Xft.h>
+
+#include "log.h"
+
+// Backend de texto sobre xcb-render. Cada glifo se rasteriza una sola vez con
+// FreeType, se sube a un glyphset por fuente y se dibuja con
+// CompositeGlyphs32. En el camino de render no se usa Xlib ni XftDraw: Xft
+// solo aporta la FT_Face ya configurada (tamaño, hinting) al cargar el glifo.
+class XRenderGlyphBackend {
+public:
+    bool init(xcb_connection_t *conn, xcb_visualid_t visual) {
+        c = conn;
+
+        xcb_render_query_version_reply_t *ver = xcb_render_query_version_reply(c,
+            xcb_render_query_version(c, 0, 11), NULL);
+        if (!ver) {
+            LOG_WARN("[xrender] RENDER extension not available");
+            return false;
+        }
+        free(ver);
+
+        xcb_render_query_pict_formats_reply_t *formats = xcb_render_query_pict_formats_reply(c,
+            xcb_render_query_pict_formats(c), NULL);
+        if (!formats) {
+            LOG_WARN("[xrender] Failed to query picture formats");
+            return false;
+        }
+
+        // Formato A8 para los glifos
+        xcb_render_pictforminfo_iterator_t fi = xcb_render_query_pict_formats_formats_iterator(formats);
+        for (; fi.rem; xcb_render_pictforminfo_next(&fi)) {
+            const xcb_render_pictforminfo_t *f = fi.data;
+            if (f->type == XCB_RENDER_PICT_TYPE_DIRECT && f->depth == 8 &&
+                f->direct.alpha_mask == 0xff && !f->direct.red_mask) {
+                glyphFormat = f->id;
+                break;
+            }
+        }
+
+        // Formato del visual de la barra, para las pictures de destino
+        xcb_render_pictscreen_iterator_t si = xcb_render_query_pict_formats_screens_iterator(formats);
+        for (; si.rem && !visualFormat; xcb_render_pictscreen_next(&si)) {
+            xcb_render_pictdepth_iterator_t di = xcb_render_pictscreen_depths_iterator(si.data);
+            for (; di.rem && !visualFormat; xcb_render_pictdepth_next(&di)) {
+                xcb_render_pictvisual_iterator_t vi = xcb_render_pictdepth_visuals_iterator(di.data);
+                for (; vi.rem; xcb_render_pictvisual_next(&vi)) {
+                    if (vi.data->visual == visual) {
+                        visualFormat = vi.data->format;
+                        break;
+                    }
+                }
+            }
+        }
+        free(formats);
+
+        if (!glyphFormat || !visualFormat) {
+            LOG_WARN("[xrender] No suitable picture format (glyph=%u visual=%u)",
+                     glyphFormat, visualFormat);
+            return false;
+        }
+        return true;
+    }
+
+    // Rasteriza ch con la cara FreeType de la fuente y lo sube al glyphset de
+    // esa fuente. Devuelve las métricas con la misma convención que
+    // XftGlyphExtents para que la barra las trate igual.
+    bool loadGlyph(int fontSlot, XftFont *font, uint32_t ch, XGlyphInfo *gi) {
+        memset(gi, 0, sizeof(*gi));
+
+        xcb_render_glyphset_t gs = glyphsetFor(fontSlot);
+        FT_Face face = XftLockFace(font);
+        if (!face)
+            return false;
+
+        FT_UInt index = FT_Get_Char_Index(face, ch);
+        if (FT_Load_Glyph(face, index, FT_LOAD_RENDER | FT_LOAD_TARGET_NORMAL)) {
+            XftUnlockFace(font);
+            return false;
+        }
+
+        FT_GlyphSlot slot = face->glyph;
+        const FT_Bitmap &bm = slot->bitmap;
+
+        gi->width = bm.width;
+        gi->height = bm.rows;
+        gi->x = -slot->bitmap_left;
+        gi->y = slot->bitmap_top;
+        gi->xOff = (slot->advance.x + 32) >> 6;
+        gi->yOff = 0;
+
+        // Las filas se suben alineadas a 4 bytes
+        int stride = (bm.width + 3) & ~3;
+        upload.assign(stride * bm.rows, 0);
+        for (unsigned int row = 0; row < bm.rows; row++) {
+            const uint8_t *src = bm.buffer + row * bm.pitch;
+            uint8_t *dst = upload.data() + row * stride;
+            if (bm.pixel_mode == FT_PIXEL_MODE_MONO) {
+                for (unsigned int col = 0; col < bm.width; col++)
+                    dst[col] = (src[col >> 3] & (0x80 >> (col & 7))) ? 0xff : 0;
+            } else {
+                memcpy(dst, src, bm.width);
+            }
+        }
+        XftUnlockFace(font);
+
+        // El avance que usa el servidor es el ancho que la barra le asigna al
+        // carácter, así un run entero cae en las mismas posiciones que medimos
+        xcb_render_glyphinfo_t info;
+        info.width = gi->width;
+        info.height = gi->height;
+        info.x = gi->x;
+        info.y = gi->y;
+        info.x_off = (gi->xOff >= (int)gi->width) ? gi->xOff : gi->width;
+        info.y_off = 0;
+
+        xcb_render_add_glyphs(c, gs, 1, &ch, &info, upload.size(), upload.data());
+        return true;
+    }
+
+    // Un run completo en un solo request. Los glifos tienen que haber pasado
+    // antes por loadGlyph (la barra lo garantiza al medirlos).
+    void drawGlyphs(xcb_drawable_t d, int fontSlot, int x, int y,
+                    const uint32_t *ucs, int len, uint32_t argb) {
+        if (len <= 0)
+            return;
+
+        // Cabecera de un glyph elt: len, pad[3], dx, dy
+        uint8_t cmd[8 + 254 * 4];
+        if (len > 254)
+            len = 254;
+        cmd[0] = len;
+        cmd[1] = cmd[2] = cmd[3] = 0;
+        int16_t dx = x, dy = y;
+        memcpy(cmd + 4, &dx, 2);
+        memcpy(cmd + 6, &dy, 2);
+        memcpy(cmd + 8, ucs, len * 4);
+
+        xcb_render_composite_glyphs_32(c, XCB_RENDER_PICT_OP_OVER,
+                                       solidFill(argb), pictureFor(d), 0,
+                                       glyphsetFor(fontSlot), 0, 0, 8 + len * 4, cmd);
+    }
+
+    // Libera la picture asociada a un drawable que se va a destruir
+    void releaseDrawable(xcb_drawable_t d) {
+        auto it = pictures.find(d);
+        if (it == pictures.end())
+            return;
+        xcb_render_free_picture(c, it->second);
+        pictures.erase(it);
+    }
+
+    void cleanup(void) {
+        if (!c)
+            return;
+        for (auto &p : pictures)
+            xcb_render_free_picture(c, p.second);
+        for (auto &p : fills)
+            xcb_render_free_picture(c, p.second);
+        for (xcb_render_glyphset_t gs : glyphsets) {
+            if (gs)
+                xcb_render_free_glyph_set(c, gs);
+        }
+        pictures.clear();
+        fills.clear();
+        glyphsets.clear();
+    }
+
+private:
+    xcb_connection_t *c = nullptr;
+    xcb_render_pictformat_t glyphFormat = 0;
+    xcb_render_pictformat_t visualFormat = 0;
+
+    std::vector<xcb_render_glyphset_t> glyphsets;                   // por fuente
+    std::unordered_map<xcb_drawable_t, xcb_render_picture_t> pictures;
+    std::unordered_map<uint32_t, xcb_render_picture_t> fills;      // por color
+    std::vector<uint8_t> upload;
+
+    xcb_render_glyphset_t glyphsetFor(int fontSlot) {
+        if ((int)glyphsets.size() <= fontSlot)
+            glyphsets.resize(fontSlot + 1, 0);
+        if (!glyphsets[fontSlot]) {
+            glyphsets[fontSlot] = xcb_generate_id(c);
+            xcb_render_create_glyph_set(c, glyphsets[fontSlot], glyphFormat);
+        }
+        return glyphsets[fontSlot];
+    }
+
+    xcb_render_picture_t pictureFor(xcb_drawable_t d) {
+        auto it = pictures.find(d);
+        if (it != pictures.end())
+            return it->second;
+        xcb_render_picture_t pic = xcb_generate_id(c);
+        xcb_render_create_picture(c, pic, d, visualFormat, 0, NULL);
+        pictures.emplace(d, pic);
+        return pic;
+    }
+
+    // argb viene premultiplicado (ver Color::parse_color)
+    xcb_render_picture_t solidFill(uint32_t argb) {
+        auto it = fills.find(argb);
+        if (it != fills.end())
+            return it->second;
+        xcb_render_color_t color;
+        color.alpha = ((argb >> 24) & 0xff) * 0x101;
+        color.red   = ((argb >> 16) & 0xff) * 0x101;
+        color.green = ((argb >> 8) & 0xff) * 0x101;
+        color.blue  = (argb & 0xff) * 0x101;
+        xcb_render_picture_t pic = xcb_generate_id(c);
+        xcb_render_create_solid_fill(c, pic, color);
+        fills.emplace(argb, pic);
+        return pic;
+    }
+};
+
+#endif // XRENDER_BACKEND_H